@@ -0,0 +1,97 @@
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "../src/headers/NeuralNetwork.h"
+
+/* Checks that the deterministic training mode gives bitwise the same network whatever the number of threads, on a
+   network with a convolution, a batch normalization and dropout, and that shards a batch leaves empty do not change
+   the running statistics of the normalization. Prints every check and returns 1 when one fails:
+       DeterminismCheck */
+
+using namespace neuralNet;
+
+constexpr int steps = 10;
+
+//gradientDescent reports every batch on std::cout, which would drown the results
+class QuietOutput {
+private:
+    std::streambuf *previous;
+    std::ostringstream sink;
+
+public:
+    QuietOutput() : previous(std::cout.rdbuf(sink.rdbuf())) {}
+
+    ~QuietOutput() {
+        std::cout.rdbuf(previous);
+    }
+};
+
+std::vector<LayerInfo> networkLayers() {
+    return {LayerInfo::input(1, 12, 12), LayerInfo::conv2D(4, 3, 1, 1), LayerInfo::maxPool(2),
+            LayerInfo::dense(32, ActivationFunction::Linear), LayerInfo::batchNorm(),
+            LayerInfo::activationLayer(ActivationFunction::Tanh), LayerInfo::dropout(0.2), LayerInfo::dense(10)};
+}
+
+Batch randomBatch(int samples, unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> pixel(0, 1);
+    Batch batch;
+    batch.reshape(samples, 144, 10);
+    for (auto &input: batch.inputs) {
+        input = pixel(generator);
+    }
+    for (int sample = 0; sample < samples; sample++) {
+        int label = static_cast<int>(generator() % 10);
+        batch.labels[sample] = label;
+        batch.expectedOutputs(sample, label) = 1;
+    }
+    return batch;
+}
+
+//Trains a network in the deterministic mode and returns its outputs for fixed samples, which depend on every weight
+std::vector<double> train(int threads, int shards, int batchSize) {
+    ThreadPool pool(threads);
+    NeuralNetwork network(networkLayers(), 64, 42);
+    network.setTrainingMode(TrainingMode::Deterministic, shards, &pool);
+    {
+        QuietOutput quiet;
+        for (int step = 0; step < steps; step++) {
+            network.gradientDescent(randomBatch(batchSize, step));
+        }
+    }
+
+    Batch probe = randomBatch(32, 1000);
+    std::vector<double> outputs;
+    for (int sample = 0; sample < probe.size(); sample++) {
+        Tensor<double> sampleOutputs = network.predict(probe.inputs.row(sample));
+        outputs.insert(outputs.end(), sampleOutputs.begin(), sampleOutputs.end());
+    }
+    return outputs;
+}
+
+//Compares the bits, so two NaNs at the same place are identical too
+bool identical(const std::vector<double> &first, const std::vector<double> &second) {
+    return first.size() == second.size()
+           && std::memcmp(first.data(), second.data(), first.size() * sizeof(double)) == 0;
+}
+
+bool check(const std::string &name, bool passed) {
+    std::cout << (passed ? "passed  " : "FAILED  ") << name << std::endl;
+    return passed;
+}
+
+int main() {
+    bool passed = true;
+    std::vector<double> reference = train(1, defaultDeterministicShards, 61);
+    for (int threads = 2; threads <= 4; threads++) {
+        passed &= check(std::to_string(threads) + " threads give the network of 1 thread",
+                        identical(reference, train(threads, defaultDeterministicShards, 61)));
+    }
+
+    //A batch of one sample leaves all shards but one empty, which must train like a single shard
+    passed &= check("empty shards leave the running statistics alone",
+                    identical(train(1, 1, 1), train(4, defaultDeterministicShards, 1)));
+    return passed ? 0 : 1;
+}
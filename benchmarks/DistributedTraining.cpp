@@ -0,0 +1,155 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../src/headers/NeuralNetwork.h"
+#include "../src/headers/CsvReader.h"
+#include "../src/headers/Sampler.h"
+
+/* Trains one network over several processes of this host, either through a ring of TCP sockets or through shared
+   memory, every process being started on its own:
+       DistributedTraining --ring <rank> <host:port>... [--data mnist.csv] [--epochs n]
+       DistributedTraining --shm <worker> <workerCount> [--data mnist.csv] [--epochs n]
+   for example, from a shell:
+       for rank in 0 1 2; do DistributedTraining --ring $rank 127.0.0.1:5000 127.0.0.1:5001 127.0.0.1:5002 & done
+       for worker in 0 1 2; do DistributedTraining --shm $worker 3 & done
+   Every process takes its own share of each batch (see Sampler), and reports the cost on the held out samples after
+   every epoch with all its digits: the processes take the same steps, so they print the same costs. Without a
+   dataset, synthetic digits are used: 10 sparse random prototypes with a few pixels flipped per sample */
+
+using namespace neuralNet;
+
+//Samples per batch of every process
+constexpr int processBatchSize = 32;
+
+//The shuffles, and the synthetic digits, must be the same in every process
+constexpr std::uint64_t sharedSeed = 1;
+
+//Name of the shared memory segment of the --shm mode
+const char *const segmentName = "DistributedTraining";
+
+//gradientDescent reports every batch on std::cout, which would drown the results
+class QuietOutput {
+private:
+    std::streambuf *previous;
+    std::ostringstream sink;
+
+public:
+    QuietOutput() : previous(std::cout.rdbuf(sink.rdbuf())) {}
+
+    ~QuietOutput() {
+        std::cout.rdbuf(previous);
+    }
+};
+
+Dataset syntheticDigits(int samples, std::mt19937 &generator) {
+    std::vector<std::vector<std::uint8_t>> prototypes(10, std::vector<std::uint8_t>(784, 0));
+    for (auto &prototype: prototypes) {
+        for (auto &pixel: prototype) {
+            pixel = generator() % 5 == 0 ? 255 : 0;
+        }
+    }
+
+    Dataset data(784, 10);
+    data.reserve(samples);
+    std::vector<std::uint8_t> pixels;
+    for (int sample = 0; sample < samples; sample++) {
+        int label = static_cast<int>(generator() % 10);
+        pixels = prototypes[label];
+        for (int flip = 0; flip < 60; flip++) {
+            std::uint8_t &pixel = pixels[generator() % 784];
+            pixel = 255 - pixel;
+        }
+        data.add(pixels.data(), label);
+    }
+    return data;
+}
+
+[[noreturn]] void usage() {
+    std::cerr << "usage: DistributedTraining --ring <rank> <host:port>... [--data mnist.csv] [--epochs n]\n"
+              << "       DistributedTraining --shm <worker> <workerCount> [--data mnist.csv] [--epochs n]"
+              << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+    if (arguments.size() < 3 || (arguments[0] != "--ring" && arguments[0] != "--shm")) {
+        usage();
+    }
+    bool useRing = arguments[0] == "--ring";
+    int rank = std::stoi(arguments[1]);
+    std::vector<std::string> addresses;
+    std::string dataPath;
+    int epochs = 3;
+    int processCount = useRing ? 0 : std::stoi(arguments[2]);
+    for (std::size_t index = useRing ? 2 : 3; index < arguments.size(); index++) {
+        if (arguments[index] == "--data" && index + 1 < arguments.size()) {
+            dataPath = arguments[++index];
+        } else if (arguments[index] == "--epochs" && index + 1 < arguments.size()) {
+            epochs = std::stoi(arguments[++index]);
+        } else if (useRing && arguments[index].rfind("--", 0) != 0) {
+            addresses.push_back(arguments[index]);
+        } else {
+            usage();
+        }
+    }
+    if (useRing) {
+        processCount = static_cast<int>(addresses.size());
+    }
+
+    try {
+        std::mt19937 generator(sharedSeed);
+        Dataset dataset = dataPath.empty() ? syntheticDigits(12000, generator) : readCsv(dataPath, 784, 10);
+
+        //The last sixth of the samples is held out
+        int trainingSamples = dataset.size() * 5 / 6;
+        Batch heldOut;
+        dataset.loadBatch(trainingSamples, dataset.size() - trainingSamples, heldOut);
+
+        NeuralNetwork network(std::vector<int>{784, 100, 10}, processBatchSize, 42);
+        std::unique_ptr<RingAllReduce> ring;
+        std::unique_ptr<SharedParameters> shared;
+        if (useRing) {
+            ring = std::make_unique<RingAllReduce>(rank, addresses);
+            network.setAllReduce(ring.get());
+        } else {
+            shared = std::make_unique<SharedParameters>(segmentName, rank, processCount,
+                                                        network.parameterBufferSize());
+            network.setSharedParameters(shared.get());
+        }
+
+        Sampler sampler(trainingSamples, processBatchSize, sharedSeed, rank, processCount);
+        std::vector<int> indices;
+        Batch batch;
+        for (int epoch = 1; epoch <= epochs; epoch++) {
+            auto start = std::chrono::steady_clock::now();
+            {
+                QuietOutput quiet;
+                for (long step = 0; step < sampler.batchesPerEpoch(); step++) {
+                    sampler(indices);
+                    dataset.loadBatch(indices, batch);
+                    network.gradientDescent(batch);
+                }
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            double samples = static_cast<double>(sampler.batchesPerEpoch()) * processBatchSize * processCount;
+            std::cout << (useRing ? "rank " : "worker ") << rank << " epoch " << epoch << "  " << std::fixed
+                      << std::setprecision(0) << samples / seconds << " samples/s  cost " << std::setprecision(17)
+                      << network.cost(heldOut) << std::endl;
+        }
+
+        //Detaching copies the shared weights back, before the segment goes away
+        if (shared) {
+            network.setSharedParameters(nullptr);
+        }
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "../src/headers/NeuralNetwork.h"
+#include "../src/headers/CsvReader.h"
+
+/* Compares Hogwild training with synchronous data parallel training (the fast mode) on the same samples:
+   throughput in samples per second, and the cost and accuracy on held out samples after every epoch.
+       HogwildBenchmark [mnist.csv] [epochs] [threads]
+   Without a dataset, synthetic digits are used: 10 sparse random prototypes with a few pixels flipped per sample */
+
+using namespace neuralNet;
+
+//Samples per update of a Hogwild worker, the synchronous batch being this times the number of threads
+constexpr int workerBatchSize = 16;
+
+//gradientDescent reports every batch on std::cout, which would drown the results
+class QuietOutput {
+private:
+    std::streambuf *previous;
+    std::ostringstream sink;
+
+public:
+    QuietOutput() : previous(std::cout.rdbuf(sink.rdbuf())) {}
+
+    ~QuietOutput() {
+        std::cout.rdbuf(previous);
+    }
+};
+
+Dataset loadCsv(const std::string &path) {
+    try {
+        return readCsv(path, 784, 10);
+    } catch (const std::runtime_error &error) {
+        std::cerr << error.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+Dataset syntheticDigits(int samples, std::mt19937 &generator) {
+    std::vector<std::vector<std::uint8_t>> prototypes(10, std::vector<std::uint8_t>(784, 0));
+    for (auto &prototype: prototypes) {
+        for (auto &pixel: prototype) {
+            pixel = generator() % 5 == 0 ? 255 : 0;
+        }
+    }
+
+    Dataset data(784, 10);
+    data.reserve(samples);
+    std::vector<std::uint8_t> pixels;
+    for (int sample = 0; sample < samples; sample++) {
+        int label = static_cast<int>(generator() % 10);
+        pixels = prototypes[label];
+        for (int flip = 0; flip < 60; flip++) {
+            std::uint8_t &pixel = pixels[generator() % 784];
+            pixel = 255 - pixel;
+        }
+        data.add(pixels.data(), label);
+    }
+    return data;
+}
+
+//Cost and accuracy over the samples [begin, end)
+void evaluate(NeuralNetwork &network, const Dataset &dataset, int begin, int end, double &cost, double &accuracy) {
+    Batch batch;
+    dataset.loadBatch(begin, end - begin, batch);
+    cost = network.cost(batch);
+
+    int correct = 0;
+    for (int sample = 0; sample < batch.size(); sample++) {
+        correct += network.classify(batch.inputs.row(sample)) == batch.labels[sample];
+    }
+    accuracy = static_cast<double>(correct) / batch.size();
+}
+
+void report(const std::string &name, int epoch, double seconds, long samples, double cost, double accuracy) {
+    std::cout << std::left << std::setw(12) << name << " epoch " << epoch << "  " << std::right << std::fixed
+              << std::setprecision(0) << std::setw(9) << samples / seconds << " samples/s  cost "
+              << std::setprecision(4) << cost << "  accuracy " << std::setprecision(2) << 100 * accuracy << "%"
+              << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::mt19937 generator(1);
+    Dataset dataset = argc > 1 ? loadCsv(argv[1]) : syntheticDigits(12000, generator);
+    int epochs = argc > 2 ? std::stoi(argv[2]) : 3;
+    int threads = argc > 3 ? std::stoi(argv[3]) : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(threads, 1);
+
+    //The last sixth of the samples is held out
+    int trainingSamples = dataset.size() * 5 / 6;
+    std::vector<int> order(trainingSamples);
+    std::iota(order.begin(), order.end(), 0);
+    ThreadPool pool(threads);
+    int synchronousBatchSize = workerBatchSize * threads;
+    std::cout << trainingSamples << " training samples, " << dataset.size() - trainingSamples << " held out, "
+              << threads << " threads" << std::endl;
+
+    //Both networks start from the same weights and see the same shuffles
+    NeuralNetwork synchronous(std::vector<int>{784, 100, 10}, synchronousBatchSize, 42);
+    NeuralNetwork hogwild(std::vector<int>{784, 100, 10}, synchronousBatchSize, 42);
+    synchronous.setTrainingMode(TrainingMode::Fast, threads, &pool);
+    hogwild.setTrainingMode(TrainingMode::Serial, 0, &pool);
+
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        std::shuffle(order.begin(), order.end(), generator);
+        double cost, accuracy;
+
+        //Synchronous: every batch waits for its slowest shard before the weights are updated
+        auto start = std::chrono::steady_clock::now();
+        {
+            QuietOutput quiet;
+            Batch batch;
+            std::vector<int> indices;
+            for (int begin = 0; begin + synchronousBatchSize <= trainingSamples; begin += synchronousBatchSize) {
+                indices.assign(order.begin() + begin, order.begin() + begin + synchronousBatchSize);
+                dataset.loadBatch(indices, batch);
+                synchronous.gradientDescent(batch);
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        evaluate(synchronous, dataset, trainingSamples, dataset.size(), cost, accuracy);
+        report("synchronous", epoch, seconds, trainingSamples / synchronousBatchSize * synchronousBatchSize, cost,
+               accuracy);
+
+        //Hogwild: worker w takes the batches w, w + threads, ... of the same shuffle, and never waits
+        start = std::chrono::steady_clock::now();
+        std::vector<int> nextBatches(threads);
+        std::iota(nextBatches.begin(), nextBatches.end(), 0);
+        long batches = hogwild.trainHogwild([&](int worker, Batch &batch) {
+            long begin = static_cast<long>(nextBatches[worker]) * workerBatchSize;
+            if (begin + workerBatchSize > trainingSamples) {
+                return false;
+            }
+            nextBatches[worker] += threads;
+            std::vector<int> indices(order.begin() + begin, order.begin() + begin + workerBatchSize);
+            dataset.loadBatch(indices, batch);
+            return true;
+        }, threads);
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        evaluate(hogwild, dataset, trainingSamples, dataset.size(), cost, accuracy);
+        report("hogwild", epoch, seconds, batches * workerBatchSize, cost, accuracy);
+    }
+    return 0;
+}
@@ -1,98 +1,69 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <random>
+#include <thread>
+#include <atomic>
+#include <cstdint>
 #include "src/headers/NeuralNetwork.h"
-
-std::vector<std::vector<double>> extractData(const std::string &datasetPath) {
-    std::ifstream file(datasetPath);
-    if (!file.is_open()) {
-        std::cout << "Couldn't open file" << std::endl;
+#include "src/headers/BatchLoader.h"
+#include "src/headers/CsvReader.h"
+#include "src/headers/DatasetCache.h"
+#include "src/headers/Sampler.h"
+#include "src/headers/GUI.h"
+
+neuralNet::Dataset extractData(const std::string &datasetPath, int inputSize, int numClasses) {
+    //The expected output for any line of data is placed first, followed by the inputs
+    long skippedLines = 0;
+    neuralNet::Dataset data(inputSize, numClasses);
+    try {
+        //The CSV is only parsed when its cache is missing or out of date
+        data = neuralNet::loadWithCache(datasetPath, inputSize, numClasses, [&]() {
+            return neuralNet::readCsv(datasetPath, inputSize, numClasses, &skippedLines);
+        });
+    } catch (const std::runtime_error &error) {
+        std::cout << "Couldn't open file: " << error.what() << std::endl;
         exit(EXIT_FAILURE);
     }
 
-    //The expected output for any line of data is placed at data[n][0]
-    std::vector<std::vector<double>> data;
-    std::string line;
-
-    while (std::getline(file, line)) {
-        std::vector<double> dataLine;
-        std::istringstream ss(line);
-        std::string value;
-        while (std::getline(ss, value, ',')) {
-            dataLine.push_back(std::stoi(value) / 255.0);
-            //dataLine.push_back(std::stoi(value));
-        }
-        data.push_back(dataLine);
+    if (skippedLines > 0) {
+        std::cout << "Skipped " << skippedLines << " lines without " << inputSize + 1 << " values" << std::endl;
     }
     return data;
 }
 
-std::vector<std::vector<double>> extractExpectedOutputs(std::vector<std::vector<double>> &data, int outputsSize) {
-    std::vector<std::vector<double>> expectedOutputs;
-
-    for (auto &dataLine: data) {
-        //Initialize all values as 0 and set the correct node to activation 1
-        std::vector<double> expectedOutput(outputsSize, 0);
-        expectedOutput[dataLine[0] * 255.0] = 1;
-
-        //Add expectedOutput and erase the expected output from the dataset
-        expectedOutputs.push_back(expectedOutput);
-        dataLine.erase(dataLine.begin());
-    }
-
-    return expectedOutputs;
-}
-
-template <typename T>
-std::vector<T> getRandomSubset(std::vector<T> largerVector, int subsetSize) {
-    // Create an empty vector to store the selected values
-    std::vector<T> subset;
-
-    // Create a random number generator
-    std::random_device rd;
-    std::mt19937 generator(rd());
-    std::uniform_int_distribution<int> dist(0, largerVector.size() - subsetSize);
-
-    int startingIndex = dist(generator);
-    subsetSize = startingIndex + subsetSize;
-
-    // Copy the randomly selected values to the subset vector
-    for (int i = startingIndex; i < subsetSize; ++i) {
-        subset.push_back(largerVector[i]);
-    }
-
-    return subset;
-}
-
 int main() {
     std::string datasetPath = R"(C:\Users\1flor\CLionProjects\CppNeuralNetwork\src\dataset\mnistDigits\mnist_test.csv)";
     std::cout << "Processing data..." << std::endl;
-    std::vector<std::vector<double>> data = extractData(datasetPath);
-    std::cout << "Creating expected outputs..." << std::endl;
-    std::vector<std::vector<double>> expectedOutputs = extractExpectedOutputs(data, 10);
-    std::cout << "Done" << std::endl;
-
-    //Create and populate the data points
-    std::vector<neuralNet::DataPoint> dataPoints;
-    for (int index = 0; index < data.size(); index++) {
-        dataPoints.emplace_back(data[index], expectedOutputs[index]);
-    }
-
     //std::vector<int> layerSizes = {2, 2};
     std::vector<int> layerSizes = {784, 100, 10};
+    neuralNet::Dataset dataset = extractData(datasetPath, layerSizes.front(), layerSizes.back());
+    std::cout << "Done, " << dataset.size() << " samples in " << dataset.memoryUsage() / 1024 << " KB" << std::endl;
+
     neuralNet::NeuralNetwork neuralNetwork(layerSizes);
 
-    std::vector<neuralNet::DataPoint> dataPoint = getRandomSubset(dataPoints, 512);
-    std::cout << "Initial cost: " << neuralNetwork.cost(dataPoint) << std::endl;
+    //The window shows the network while it trains, so training happens on its own thread
+    GUIWindow window(1280, 720, "CppNeuralNetwork");
+    window.attachNetwork(&neuralNetwork, &dataset);
+    std::atomic<bool> windowClosed = false;
+
+    std::thread trainingThread([&]() {
+        //Batches are picked, converted, augmented and packed on background threads while the network trains
+        neuralNet::Augmentation augmentation({1, 28, 28});
+        neuralNet::BatchLoader loader(dataset, neuralNet::Sampler(dataset.size(), 512), 2,
+                                      neuralNet::defaultPrefetchBatches, &augmentation);
+        const neuralNet::Batch *batch = loader.next();
+        std::cout << "Initial cost: " << neuralNetwork.cost(*batch) << std::endl;
+
+        for (int iteration = 0; iteration < 1000 && !windowClosed; iteration++) {
+            neuralNetwork.gradientDescent(*batch);
+            std::cout << "Cost: " <<  neuralNetwork.cost(*batch) << std::endl;
+            batch = loader.next();
+        }
 
-    for (int iteration = 0; iteration < 1000; iteration++) {
-        neuralNetwork.gradientDescent(dataPoint);
-        std::cout << "Cost: " <<  neuralNetwork.cost(dataPoint) << std::endl;
-        dataPoint = getRandomSubset(dataPoints, 512);
-    }
+        std::cout << "Cost: " <<  neuralNetwork.cost(*batch) << std::endl;
+    });
 
-    std::cout << "Cost: " <<  neuralNetwork.cost(dataPoint) << std::endl;
+    window.run();
+    windowClosed = true;
+    trainingThread.join();
 
     return 0;
 }
@@ -0,0 +1,62 @@
+#include "headers/ActivationLayer.h"
+
+using namespace neuralNet;
+
+// <-- ACTIVATION LAYER IMPLEMENTATION --> //
+
+ActivationLayer::ActivationLayer(ActivationFunction activation, ImageShape shape) {
+    this->activation = activation;
+    this->shape = shape;
+}
+
+const ImageShape &ActivationLayer::getOutputShape() const {
+    return shape;
+}
+
+ActivationFunction ActivationLayer::getActivationFunction() const {
+    return activation;
+}
+
+long ActivationLayer::parameterCount() const {
+    return 0;
+}
+
+void ActivationLayer::bindParameters(TensorView<double> parameters, TensorView<double> gradients) {}
+
+void ActivationLayer::initializeParameters(std::uint64_t seed) {}
+
+std::size_t ActivationLayer::workspaceBytes(long batchSize) const {
+    //Activations, then the gradients of the inputs
+    return 2 * Arena::bytesFor<double>(batchSize * shape.size());
+}
+
+TensorView<const double> ActivationLayer::getActivations() const {
+    return activations;
+}
+
+void ActivationLayer::computeActivations(TensorView<const double> inputs, TensorView<double> outputs,
+                                         Arena &arena) const {
+    outputs.copyFrom(inputs);
+    for (long sample = 0; sample < outputs.dim(0); sample++) {
+        applyActivation(activation, outputs.row(sample).data(), shape.size());
+    }
+}
+
+void ActivationLayer::calculateOutputs(TensorView<const double> inputs, Arena &arena) {
+    activations = arena.allocate<double>({inputs.dim(0), shape.size()});
+    computeActivations(inputs, activations, arena);
+}
+
+TensorView<const double> ActivationLayer::backPropagate(TensorView<const double> outputGradients, Arena &arena,
+                                                        bool needInputGradients) {
+    if (!needInputGradients) {
+        return {};
+    }
+
+    TensorView<double> inputGradients = arena.allocate<double>({outputGradients.dim(0), shape.size()});
+    for (long sample = 0; sample < outputGradients.dim(0); sample++) {
+        multiplyActivationDerivative(activation, activations.row(sample).data(), outputGradients.row(sample).data(),
+                                     inputGradients.row(sample).data(), shape.size());
+    }
+    return inputGradients;
+}
@@ -0,0 +1,60 @@
+#include "headers/Arena.h"
+#include <algorithm>
+
+using namespace neuralNet;
+
+// <-- ARENA IMPLEMENTATION --> //
+
+Arena::Arena(std::size_t initialCapacity) {
+    addBlock(initialCapacity);
+}
+
+void Arena::addBlock(std::size_t minimumSize) {
+    //Round up to whole cache lines, so every block starts and ends aligned
+    std::size_t size = (minimumSize + tensorAlignment - 1) / tensorAlignment * tensorAlignment;
+    auto *memory = static_cast<std::byte *>(::operator new(size, std::align_val_t(tensorAlignment)));
+    blocks.push_back({std::unique_ptr<std::byte, AlignedDeleter>(memory), size});
+}
+
+void *Arena::allocateBytes(std::size_t bytes, std::size_t alignment) {
+    std::size_t alignedOffset = (offset + alignment - 1) / alignment * alignment;
+
+    //Move on to the next block (or add one) when this one does not have room left
+    while (alignedOffset + bytes > blocks[currentBlock].size) {
+        if (currentBlock + 1 == blocks.size()) {
+            addBlock(std::max(bytes + alignment, blocks[currentBlock].size * 2));
+        }
+        currentBlock++;
+        offset = 0;
+        alignedOffset = 0;
+    }
+
+    usedBytes += alignedOffset - offset + bytes;
+    offset = alignedOffset + bytes;
+    return blocks[currentBlock].memory.get() + alignedOffset;
+}
+
+void Arena::reset() {
+    //Replace the blocks with a single one big enough for everything this step needed
+    if (blocks.size() > 1) {
+        std::size_t total = capacity();
+        blocks.clear();
+        addBlock(total);
+    }
+
+    currentBlock = 0;
+    offset = 0;
+    usedBytes = 0;
+}
+
+std::size_t Arena::used() const {
+    return usedBytes;
+}
+
+std::size_t Arena::capacity() const {
+    std::size_t total = 0;
+    for (auto &block: blocks) {
+        total += block.size;
+    }
+    return total;
+}
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "headers/Augmentation.h"
+
+using namespace neuralNet;
+
+// <-- HELPER FUNCTIONS --> //
+
+//Random streams of a sample: the transformation, the two elastic displacements and the noise
+constexpr std::uint32_t transformStream = 0;
+constexpr std::uint32_t elasticStreamX = 1;
+constexpr std::uint32_t elasticStreamY = 2;
+constexpr std::uint32_t noiseStream = 3;
+
+//Zeros left and above the image in the padded copy, there are two on the right and below for the far neighbours
+constexpr int paddingBefore = 1;
+constexpr int paddingAfter = 2;
+
+//Adds the taps of a gaussian along a row of length, into out
+void smoothRow(const double *in, double *out, int length, const std::vector<double> &kernel) {
+    int radius = static_cast<int>(kernel.size()) / 2;
+    std::fill(out, out + length, 0.0);
+    for (int tap = 0; tap < kernel.size(); tap++) {
+        int offset = tap - radius;
+        int begin = std::max(0, -offset);
+        int end = std::min(length, length - offset);
+        double weight = kernel[tap];
+        for (int index = begin; index < end; index++) {
+            out[index] += weight * in[index + offset];
+        }
+    }
+}
+
+// <-- AUGMENTATION IMPLEMENTATION --> //
+
+Augmentation::Augmentation(ImageShape shape, AugmentationSettings settings, std::uint64_t seed)
+        : shape(shape), settings(settings), seed(seed) {
+    if (settings.maxShift < 0 || settings.maxRotation < 0 || settings.minScale <= 0
+        || settings.maxScale < settings.minScale || settings.elasticAlpha < 0 || settings.noise < 0
+        || (settings.elasticAlpha > 0 && settings.elasticSigma <= 0)) {
+        throw std::invalid_argument("The augmentation settings must be positive, with minScale <= maxScale");
+    }
+
+    //The gaussian is cut at 3 deviations, and the strength of the distortion is split over its two passes
+    if (settings.elasticAlpha > 0) {
+        int radius = static_cast<int>(std::ceil(3 * settings.elasticSigma));
+        double sum = 0;
+        for (int offset = -radius; offset <= radius; offset++) {
+            double weight = std::exp(-offset * offset / (2 * settings.elasticSigma * settings.elasticSigma));
+            smoothingKernel.push_back(weight);
+            sum += weight;
+        }
+        for (auto &weight: smoothingKernel) {
+            weight *= std::sqrt(settings.elasticAlpha) / sum;
+        }
+    }
+}
+
+const ImageShape &Augmentation::getShape() const {
+    return shape;
+}
+
+void Augmentation::elasticField(Philox::Key sampleKey, Workspace &workspace) const {
+    int width = shape.width;
+    int height = shape.height;
+    long pixels = static_cast<long>(width) * height;
+    workspace.smoothing.resize(pixels);
+
+    //Each axis is smoothed on its own: along the rows into the scratch buffer, then along the columns back
+    for (auto [field, stream]: {std::make_pair(&workspace.fieldX, elasticStreamX),
+                                std::make_pair(&workspace.fieldY, elasticStreamY)}) {
+        field->resize(pixels);
+        fillNormal(field->data(), 0, pixels, 1, sampleKey, stream);
+
+        for (int row = 0; row < height; row++) {
+            smoothRow(field->data() + row * width, workspace.smoothing.data() + row * width, width, smoothingKernel);
+        }
+
+        int radius = static_cast<int>(smoothingKernel.size()) / 2;
+        std::fill(field->begin(), field->end(), 0.0);
+        for (int row = 0; row < height; row++) {
+            double *out = field->data() + row * width;
+            for (int tap = std::max(0, radius - row); tap < smoothingKernel.size() && row + tap - radius < height;
+                 tap++) {
+                const double *in = workspace.smoothing.data() + (row + tap - radius) * width;
+                double weight = smoothingKernel[tap];
+                for (int column = 0; column < width; column++) {
+                    out[column] += weight * in[column];
+                }
+            }
+        }
+    }
+}
+
+void Augmentation::apply(const std::uint8_t *image, double *target, double inputScale, std::uint64_t sample,
+                         Workspace &workspace) const {
+    constexpr double toUnit = 1.0 / 4294967296.0;
+    int width = shape.width;
+    int height = shape.height;
+    long pixels = static_cast<long>(width) * height;
+    Philox::Key sampleKey = Philox::key(mixSeed(seed, sample));
+
+    //Each of the 4 numbers of the transformation counter gives a value in [-1, 1) or [0, 1)
+    Philox::Counter numbers = Philox::generate({0, transformStream, 0, 1}, sampleKey);
+    auto symmetric = [&](int index) { return 2 * numbers[index] * toUnit - 1; };
+    double shiftX = symmetric(0) * settings.maxShift;
+    double shiftY = symmetric(1) * settings.maxShift;
+    double angle = symmetric(2) * settings.maxRotation;
+    double scale = settings.minScale + numbers[3] * toUnit * (settings.maxScale - settings.minScale);
+
+    /* Every output pixel is taken from the image through the inverse transformation, around the centre of the
+       image: back by the shift, the rotation and the zoom */
+    double cosine = std::cos(angle) / scale;
+    double sine = std::sin(angle) / scale;
+    double centreX = (width - 1) / 2.0;
+    double centreY = (height - 1) / 2.0;
+    workspace.sourceX.resize(pixels);
+    workspace.sourceY.resize(pixels);
+    double *sourceX = workspace.sourceX.data();
+    double *sourceY = workspace.sourceY.data();
+    for (int row = 0; row < height; row++) {
+        double offsetY = row - centreY - shiftY;
+        double rowX = centreX + sine * offsetY;
+        double rowY = centreY + cosine * offsetY;
+        for (int column = 0; column < width; column++) {
+            double offsetX = column - centreX - shiftX;
+            sourceX[row * width + column] = rowX + cosine * offsetX;
+            sourceY[row * width + column] = rowY - sine * offsetX;
+        }
+    }
+
+    if (!smoothingKernel.empty()) {
+        elasticField(sampleKey, workspace);
+        const double *fieldX = workspace.fieldX.data();
+        const double *fieldY = workspace.fieldY.data();
+        for (long pixel = 0; pixel < pixels; pixel++) {
+            sourceX[pixel] += fieldX[pixel];
+            sourceY[pixel] += fieldY[pixel];
+        }
+    }
+
+    int paddedWidth = width + paddingBefore + paddingAfter;
+    int paddedHeight = height + paddingBefore + paddingAfter;
+
+    /* Anything further out than the first row or column of padding reads as that padding, which is 0 anyway. Once
+       clamped and moved into the padded image the positions are not negative, so truncating them is their floor,
+       and the positions are replaced by their fractions. The corners are the same for every channel */
+    workspace.cornerIndices.resize(pixels);
+    int *cornerIndices = workspace.cornerIndices.data();
+    for (long pixel = 0; pixel < pixels; pixel++) {
+        double paddedX = std::clamp(sourceX[pixel], -1.0, static_cast<double>(width)) + paddingBefore;
+        double paddedY = std::clamp(sourceY[pixel], -1.0, static_cast<double>(height)) + paddingBefore;
+        int column = static_cast<int>(paddedX);
+        int row = static_cast<int>(paddedY);
+        sourceX[pixel] = paddedX - column;
+        sourceY[pixel] = paddedY - row;
+        cornerIndices[pixel] = row * paddedWidth + column;
+    }
+    const double *fractionsX = sourceX;
+    const double *fractionsY = sourceY;
+    workspace.corners.resize(4 * pixels);
+    double *topLeft = workspace.corners.data();
+    double *topRight = topLeft + pixels;
+    double *bottomLeft = topRight + pixels;
+    double *bottomRight = bottomLeft + pixels;
+    if (workspace.padded.size() != static_cast<std::size_t>(paddedWidth) * paddedHeight) {
+        workspace.padded.assign(static_cast<std::size_t>(paddedWidth) * paddedHeight, 0.0);
+    }
+    if (settings.noise > 0) {
+        workspace.noise.resize(shape.size());
+        fillNormal(workspace.noise.data(), 0, shape.size(), settings.noise, sampleKey, noiseStream);
+    }
+
+    for (int channel = 0; channel < shape.channels; channel++) {
+        //The channel is scaled on its way into the padding, so resampling gives inputs straight away
+        const std::uint8_t *channelImage = image + channel * pixels;
+        for (int row = 0; row < height; row++) {
+            double *paddedRow = workspace.padded.data() + (row + paddingBefore) * paddedWidth + paddingBefore;
+            for (int column = 0; column < width; column++) {
+                paddedRow[column] = channelImage[row * width + column] * inputScale;
+            }
+        }
+
+        /* Bilinear resampling in two passes: the corners of each pixel (at index, index + 1 and a padded row below)
+           are gathered into contiguous arrays, which is the only scalar loop, then interpolated in a loop of plain
+           arithmetic over those arrays that the compiler vectorizes */
+        const double *padded = workspace.padded.data();
+        for (long pixel = 0; pixel < pixels; pixel++) {
+            const double *corner = padded + cornerIndices[pixel];
+            topLeft[pixel] = corner[0];
+            topRight[pixel] = corner[1];
+            bottomLeft[pixel] = corner[paddedWidth];
+            bottomRight[pixel] = corner[paddedWidth + 1];
+        }
+        double *channelTarget = target + channel * pixels;
+        for (long pixel = 0; pixel < pixels; pixel++) {
+            double top = topLeft[pixel] + fractionsX[pixel] * (topRight[pixel] - topLeft[pixel]);
+            double bottom = bottomLeft[pixel] + fractionsX[pixel] * (bottomRight[pixel] - bottomLeft[pixel]);
+            channelTarget[pixel] = top + fractionsY[pixel] * (bottom - top);
+        }
+
+        if (settings.noise > 0) {
+            const double *noise = workspace.noise.data() + channel * pixels;
+            for (long pixel = 0; pixel < pixels; pixel++) {
+                channelTarget[pixel] += noise[pixel];
+            }
+        }
+    }
+}
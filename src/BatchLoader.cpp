@@ -0,0 +1,157 @@
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "headers/BatchLoader.h"
+
+using namespace neuralNet;
+
+// <-- BATCH LOADER IMPLEMENTATION --> //
+
+BatchLoader::BatchLoader(const Dataset &dataset, IndexSampler sampler, int packingThreads, int prefetch,
+                         const Augmentation *augmentation)
+        : BatchLoader(SampleSource(&dataset), std::move(sampler), packingThreads, prefetch, augmentation) {}
+
+BatchLoader::BatchLoader(const ShardedDataset &dataset, IndexSampler sampler, int packingThreads, int prefetch,
+                         const Augmentation *augmentation)
+        : BatchLoader(SampleSource(&dataset), std::move(sampler), packingThreads, prefetch, augmentation) {}
+
+BatchLoader::BatchLoader(SampleSource source, IndexSampler sampler, int packingThreads, int prefetch,
+                         const Augmentation *augmentation)
+        : source(source), sampler(std::move(sampler)), augmentation(augmentation), sampledBatches(prefetch) {
+    if (packingThreads < 1 || prefetch < 1) {
+        throw std::invalid_argument("A batch loader needs at least one packing thread and one batch to prefetch");
+    }
+    long sampleSize = std::visit([](auto *dataset) { return dataset->sampleSize(); }, source);
+    if (augmentation && augmentation->getShape().size() != sampleSize) {
+        throw std::invalid_argument("The augmentation is for images of "
+                                    + std::to_string(augmentation->getShape().size()) + " values, the samples have "
+                                    + std::to_string(sampleSize));
+    }
+
+    //One more slot than prefetched, for the batch the caller is working on
+    slots.resize(prefetch + 1);
+    for (int thread = 0; thread < packingThreads; thread++) {
+        this->packingThreads.emplace_back([this]() { packLoop(); });
+    }
+    samplingThread = std::thread([this]() { sampleLoop(); });
+}
+
+BatchLoader::~BatchLoader() {
+    stop();
+}
+
+void BatchLoader::fail() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (!error) {
+            error = std::current_exception();
+        }
+        stopping = true;
+    }
+    sampledBatches.close();
+    slotChanged.notify_all();
+}
+
+void BatchLoader::sampleLoop() {
+    try {
+        long samples = 0;
+        for (long batch = 0;; batch++) {
+            Slot &slot = slots[batch % slots.size()];
+            {
+                std::unique_lock<std::mutex> lock(stateMutex);
+                slotChanged.wait(lock, [&]() { return stopping || slot.state == SlotState::Free; });
+                if (stopping) {
+                    return;
+                }
+            }
+
+            //A free slot belongs to this thread until it is queued
+            if (!sampler(slot.indices)) {
+                {
+                    std::lock_guard<std::mutex> lock(stateMutex);
+                    batchCount = batch;
+                }
+                sampledBatches.close();
+                slotChanged.notify_all();
+                return;
+            }
+            slot.firstSample = samples;
+            samples += static_cast<long>(slot.indices.size());
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                slot.state = SlotState::Packing;
+            }
+            if (!sampledBatches.push(batch)) {
+                return;
+            }
+        }
+    } catch (...) {
+        fail();
+    }
+}
+
+void BatchLoader::packLoop() {
+    try {
+        Augmentation::Workspace workspace;
+        long batch;
+        while (sampledBatches.pop(batch)) {
+            Slot &slot = slots[batch % slots.size()];
+            std::visit([&](auto *dataset) {
+                dataset->loadBatch(slot.indices, slot.batch);
+                if (augmentation) {
+                    //The augmented inputs replace the plain ones, the labels and expected outputs stay as loaded
+                    for (int row = 0; row < slot.batch.size(); row++) {
+                        augmentation->apply(dataset->sample(slot.indices[row]), slot.batch.inputs.row(row).data(),
+                                            dataset->scale(), slot.firstSample + row, workspace);
+                    }
+                }
+            }, source);
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                slot.state = SlotState::Ready;
+            }
+            slotChanged.notify_all();
+        }
+    } catch (...) {
+        fail();
+    }
+}
+
+const Batch *BatchLoader::next() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    if (nextBatch > 0) {
+        slots[(nextBatch - 1) % slots.size()].state = SlotState::Free;
+        slotChanged.notify_all();
+    }
+
+    Slot &slot = slots[nextBatch % slots.size()];
+    slotChanged.wait(lock, [&]() {
+        return error || stopping || batchCount == nextBatch || slot.state == SlotState::Ready;
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (stopping || slot.state != SlotState::Ready) {
+        return nullptr;
+    }
+    nextBatch++;
+    return &slot.batch;
+}
+
+void BatchLoader::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    sampledBatches.close();
+    slotChanged.notify_all();
+
+    if (samplingThread.joinable()) {
+        samplingThread.join();
+    }
+    for (auto &thread: packingThreads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
@@ -0,0 +1,236 @@
+#include <cmath>
+#include "headers/BatchNormLayer.h"
+
+using namespace neuralNet;
+
+// <-- BATCH NORMALIZATION LAYER IMPLEMENTATION --> //
+
+BatchNormLayer::BatchNormLayer(ImageShape shape) {
+    this->shape = shape;
+
+    //Plain vectors have a feature per value, images a feature per channel
+    if (shape.channels == 1 && shape.height == 1) {
+        features = shape.width;
+        pixels = 1;
+    } else {
+        features = shape.channels;
+        pixels = static_cast<long>(shape.height) * shape.width;
+    }
+    runningMeans = Tensor<double>({features});
+    runningVariances = Tensor<double>({features});
+}
+
+const ImageShape &BatchNormLayer::getOutputShape() const {
+    return shape;
+}
+
+int BatchNormLayer::featureCount() const {
+    return features;
+}
+
+long BatchNormLayer::parameterCount() const {
+    return 2L * features;
+}
+
+void BatchNormLayer::bindParameters(TensorView<double> parameters, TensorView<double> gradients) {
+    gammas = parameters.slice(0, features);
+    betas = parameters.slice(features, 2L * features);
+    costGradientGamma = gradients.slice(0, features);
+    costGradientBeta = gradients.slice(features, 2L * features);
+}
+
+void BatchNormLayer::initializeParameters(std::uint64_t seed) {
+    gammas.fill(1);
+    betas.fill(0);
+    runningMeans.view().fill(0);
+    runningVariances.view().fill(1);
+}
+
+std::size_t BatchNormLayer::workspaceBytes(long batchSize) const {
+    //Activations, normalized values and gradients of the inputs, then a few values per feature in both directions
+    return 3 * Arena::bytesFor<double>(batchSize * shape.size()) + 4 * Arena::bytesFor<double>(features);
+}
+
+TensorView<const double> BatchNormLayer::getActivations() const {
+    return activations;
+}
+
+void BatchNormLayer::computeActivations(TensorView<const double> inputs, TensorView<double> outputs,
+                                        Arena &arena) const {
+    if (folded) {
+        outputs.copyFrom(inputs);
+        return;
+    }
+
+    TensorView<double> scales = arena.allocate<double>({features});
+    TensorView<double> shifts = arena.allocate<double>({features});
+    for (int feature = 0; feature < features; feature++) {
+        scales[feature] = gammas[feature] / std::sqrt(runningVariances[feature] + batchNormEpsilon);
+        shifts[feature] = betas[feature] - runningMeans[feature] * scales[feature];
+    }
+
+    for (long sample = 0; sample < inputs.dim(0); sample++) {
+        const double *inputRow = inputs.row(sample).data();
+        double *outputRow = outputs.row(sample).data();
+        for (int feature = 0; feature < features; feature++) {
+            for (long index = feature * pixels; index < (feature + 1) * pixels; index++) {
+                outputRow[index] = inputRow[index] * scales[feature] + shifts[feature];
+            }
+        }
+    }
+}
+
+void BatchNormLayer::calculateOutputs(TensorView<const double> inputs, Arena &arena) {
+    if (folded) {
+        activations = inputs;
+        return;
+    }
+
+    long batchSize = inputs.dim(0);
+    double count = static_cast<double>(batchSize * pixels);
+    TensorView<double> outputs = arena.allocate<double>({batchSize, shape.size()});
+    normalized = arena.allocate<double>({batchSize, shape.size()});
+    inverseDeviations = arena.allocate<double>({features});
+    TensorView<double> means = arena.allocate<double>({features});
+
+    //Means first, then the variances around them, which is more accurate than adding up the squares in one pass
+    means.fill(0);
+    inverseDeviations.fill(0);
+    for (long sample = 0; sample < batchSize; sample++) {
+        const double *inputRow = inputs.row(sample).data();
+        for (int feature = 0; feature < features; feature++) {
+            for (long index = feature * pixels; index < (feature + 1) * pixels; index++) {
+                means[feature] += inputRow[index];
+            }
+        }
+    }
+    for (int feature = 0; feature < features; feature++) {
+        means[feature] /= count;
+    }
+    for (long sample = 0; sample < batchSize; sample++) {
+        const double *inputRow = inputs.row(sample).data();
+        for (int feature = 0; feature < features; feature++) {
+            for (long index = feature * pixels; index < (feature + 1) * pixels; index++) {
+                double deviation = inputRow[index] - means[feature];
+                inverseDeviations[feature] += deviation * deviation;
+            }
+        }
+    }
+
+    //The running variances are unbiased, since inference sees the whole population rather than one batch
+    double unbiasedCorrection = count > 1 ? count / (count - 1) : 1;
+    for (int feature = 0; feature < features; feature++) {
+        double variance = inverseDeviations[feature] / count;
+        runningMeans[feature] = batchNormMomentum * runningMeans[feature] + (1 - batchNormMomentum) * means[feature];
+        runningVariances[feature] = batchNormMomentum * runningVariances[feature]
+                                    + (1 - batchNormMomentum) * variance * unbiasedCorrection;
+        inverseDeviations[feature] = 1 / std::sqrt(variance + batchNormEpsilon);
+    }
+
+    for (long sample = 0; sample < batchSize; sample++) {
+        const double *inputRow = inputs.row(sample).data();
+        double *normalizedRow = normalized.row(sample).data();
+        double *outputRow = outputs.row(sample).data();
+        for (int feature = 0; feature < features; feature++) {
+            for (long index = feature * pixels; index < (feature + 1) * pixels; index++) {
+                normalizedRow[index] = (inputRow[index] - means[feature]) * inverseDeviations[feature];
+                outputRow[index] = gammas[feature] * normalizedRow[index] + betas[feature];
+            }
+        }
+    }
+    activations = outputs;
+}
+
+TensorView<const double> BatchNormLayer::backPropagate(TensorView<const double> outputGradients, Arena &arena,
+                                                       bool needInputGradients) {
+    if (folded) {
+        return needInputGradients ? outputGradients : TensorView<const double>();
+    }
+
+    //Sums over the batch of the derivatives with respect to the outputs, alone and times the normalized values
+    long batchSize = outputGradients.dim(0);
+    TensorView<double> gradientSums = arena.allocate<double>({features});
+    TensorView<double> normalizedSums = arena.allocate<double>({features});
+    gradientSums.fill(0);
+    normalizedSums.fill(0);
+    for (long sample = 0; sample < batchSize; sample++) {
+        const double *gradientRow = outputGradients.row(sample).data();
+        const double *normalizedRow = normalized.row(sample).data();
+        for (int feature = 0; feature < features; feature++) {
+            for (long index = feature * pixels; index < (feature + 1) * pixels; index++) {
+                gradientSums[feature] += gradientRow[index];
+                normalizedSums[feature] += gradientRow[index] * normalizedRow[index];
+            }
+        }
+    }
+    for (int feature = 0; feature < features; feature++) {
+        costGradientGamma[feature] += normalizedSums[feature];
+        costGradientBeta[feature] += gradientSums[feature];
+    }
+
+    if (!needInputGradients) {
+        return {};
+    }
+
+    /* Every input moves the mean and the variance of its feature, which moves every normalized value of the batch.
+       Adding that up gives gamma / (deviation * count) * (count * dy - sum(dy) - normalized * sum(dy * normalized)) */
+    double count = static_cast<double>(batchSize * pixels);
+    TensorView<double> inputGradients = arena.allocate<double>({batchSize, shape.size()});
+    for (long sample = 0; sample < batchSize; sample++) {
+        const double *gradientRow = outputGradients.row(sample).data();
+        const double *normalizedRow = normalized.row(sample).data();
+        double *inputGradientRow = inputGradients.row(sample).data();
+        for (int feature = 0; feature < features; feature++) {
+            double factor = gammas[feature] * inverseDeviations[feature] / count;
+            for (long index = feature * pixels; index < (feature + 1) * pixels; index++) {
+                inputGradientRow[index] = factor * (count * gradientRow[index] - gradientSums[feature]
+                                                    - normalizedRow[index] * normalizedSums[feature]);
+            }
+        }
+    }
+    return inputGradients;
+}
+
+void BatchNormLayer::inferenceTransform(Tensor<double> &scales, Tensor<double> &shifts) const {
+    scales = Tensor<double>({features});
+    shifts = Tensor<double>({features});
+    for (int feature = 0; feature < features; feature++) {
+        scales[feature] = gammas[feature] / std::sqrt(runningVariances[feature] + batchNormEpsilon);
+        shifts[feature] = betas[feature] - runningMeans[feature] * scales[feature];
+    }
+}
+
+void BatchNormLayer::mergeRunningStatistics(const std::vector<BatchNormLayer *> &replicas) {
+    if (replicas.empty()) {
+        return;
+    }
+    for (int feature = 0; feature < features; feature++) {
+        double meanSum = 0;
+        double varianceSum = 0;
+        for (auto *replica: replicas) {
+            meanSum += replica->runningMeans[feature];
+            varianceSum += replica->runningVariances[feature];
+        }
+        runningMeans[feature] = meanSum / static_cast<double>(replicas.size());
+        runningVariances[feature] = varianceSum / static_cast<double>(replicas.size());
+    }
+    for (auto *replica: replicas) {
+        replica->runningMeans = runningMeans;
+        replica->runningVariances = runningVariances;
+    }
+}
+
+void BatchNormLayer::copyRunningStatistics(const BatchNormLayer &other) {
+    if (&other != this) {
+        runningMeans.view().copyFrom(other.runningMeans);
+        runningVariances.view().copyFrom(other.runningVariances);
+    }
+}
+
+void BatchNormLayer::markFolded() {
+    folded = true;
+}
+
+bool BatchNormLayer::isFolded() const {
+    return folded;
+}
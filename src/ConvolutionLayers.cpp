@@ -0,0 +1,403 @@
+#include "headers/ConvolutionLayers.h"
+#include "headers/Activation.h"
+#include "headers/Gemm.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+using namespace neuralNet;
+
+// <-- CONV2D LAYER IMPLEMENTATION --> //
+
+Conv2DLayer::Conv2DLayer(ImageShape inputShape, int outChannels, int kernelSize, int stride, int padding,
+                         ActivationFunction activation, InitScheme initialization) {
+    //Integer division truncates toward zero, so a kernel bigger than the image would still give a row of outputs
+    if (outChannels < 1 || kernelSize < 1 || stride < 1 || padding < 0
+        || kernelSize > inputShape.height + 2 * padding || kernelSize > inputShape.width + 2 * padding) {
+        throw std::invalid_argument("A convolution needs at least one channel, a kernel and stride of at least 1, no "
+                                    "negative padding, and a kernel of " + std::to_string(kernelSize)
+                                    + " that fits in the padded image");
+    }
+    this->inputShape = inputShape;
+    this->kernelSize = kernelSize;
+    this->stride = stride;
+    this->padding = padding;
+    this->activation = activation;
+    this->initialization = initialization == InitScheme::Default ? InitScheme::LeCun : initialization;
+
+    outputShape.channels = outChannels;
+    outputShape.height = (inputShape.height + 2 * padding - kernelSize) / stride + 1;
+    outputShape.width = (inputShape.width + 2 * padding - kernelSize) / stride + 1;
+}
+
+long Conv2DLayer::parameterCount() const {
+    return outputShape.channels * (patchSize() + 1);
+}
+
+void Conv2DLayer::bindParameters(TensorView<double> parameters, TensorView<double> gradients) {
+    long weightCount = outputShape.channels * patchSize();
+    weights = parameters.slice(0, weightCount).reshape({outputShape.channels, patchSize()});
+    biases = parameters.slice(weightCount, parameterCount());
+    costGradientW = gradients.slice(0, weightCount).reshape({outputShape.channels, patchSize()});
+    costGradientB = gradients.slice(weightCount, parameterCount());
+}
+
+std::size_t Conv2DLayer::workspaceBytes(long batchSize) const {
+    /* Activations, the unrolled image of the forward and backward pass, the gradient products of a sample,
+       and the gradients of the unrolled image and of the inputs */
+    return Arena::bytesFor<double>(batchSize * outputShape.size())
+           + 2 * Arena::bytesFor<double>(patchSize() * outputPixels())
+           + Arena::bytesFor<double>(outputShape.size())
+           + Arena::bytesFor<double>(patchSize() * outputPixels())
+           + Arena::bytesFor<double>(batchSize * inputShape.size());
+}
+
+void Conv2DLayer::initializeParameters(std::uint64_t seed) {
+    //A kernel value is used by every output pixel, but each output only adds up one patch
+    initializeWeights(initialization, weights, biases, patchSize(),
+                      static_cast<long>(outputShape.channels) * kernelSize * kernelSize, seed);
+}
+
+long Conv2DLayer::patchSize() const {
+    return static_cast<long>(inputShape.channels) * kernelSize * kernelSize;
+}
+
+long Conv2DLayer::outputPixels() const {
+    return static_cast<long>(outputShape.height) * outputShape.width;
+}
+
+void Conv2DLayer::im2col(const double *image, TensorView<double> columns) const {
+    for (int channel = 0; channel < inputShape.channels; channel++) {
+        const double *channelPixels = image + static_cast<long>(channel) * inputShape.height * inputShape.width;
+
+        for (int kernelY = 0; kernelY < kernelSize; kernelY++) {
+            for (int kernelX = 0; kernelX < kernelSize; kernelX++) {
+                double *column = columns.row((static_cast<long>(channel) * kernelSize + kernelY) * kernelSize
+                                             + kernelX).data();
+
+                //Each row of the unrolled image is the input pixel under one kernel position, for every output pixel
+                for (int outY = 0; outY < outputShape.height; outY++) {
+                    int inY = outY * stride - padding + kernelY;
+                    double *target = column + static_cast<long>(outY) * outputShape.width;
+
+                    if (inY < 0 || inY >= inputShape.height) {
+                        std::fill(target, target + outputShape.width, 0.0);
+                        continue;
+                    }
+                    const double *inputRow = channelPixels + static_cast<long>(inY) * inputShape.width;
+                    for (int outX = 0; outX < outputShape.width; outX++) {
+                        int inX = outX * stride - padding + kernelX;
+                        target[outX] = inX >= 0 && inX < inputShape.width ? inputRow[inX] : 0.0;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void Conv2DLayer::col2im(TensorView<const double> columns, double *image) const {
+    for (int channel = 0; channel < inputShape.channels; channel++) {
+        double *channelPixels = image + static_cast<long>(channel) * inputShape.height * inputShape.width;
+
+        for (int kernelY = 0; kernelY < kernelSize; kernelY++) {
+            for (int kernelX = 0; kernelX < kernelSize; kernelX++) {
+                const double *column = columns.row((static_cast<long>(channel) * kernelSize + kernelY) * kernelSize
+                                                   + kernelX).data();
+
+                //The padding has no pixel to add to, so the values that came from it are dropped
+                for (int outY = 0; outY < outputShape.height; outY++) {
+                    int inY = outY * stride - padding + kernelY;
+                    if (inY < 0 || inY >= inputShape.height) {
+                        continue;
+                    }
+                    const double *source = column + static_cast<long>(outY) * outputShape.width;
+                    double *inputRow = channelPixels + static_cast<long>(inY) * inputShape.width;
+                    for (int outX = 0; outX < outputShape.width; outX++) {
+                        int inX = outX * stride - padding + kernelX;
+                        if (inX >= 0 && inX < inputShape.width) {
+                            inputRow[inX] += source[outX];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+const ImageShape &Conv2DLayer::getOutputShape() const {
+    return outputShape;
+}
+
+ActivationFunction Conv2DLayer::getActivationFunction() const {
+    return activation;
+}
+
+TensorView<const double> Conv2DLayer::getActivations() const {
+    return activations;
+}
+
+TensorView<const double> Conv2DLayer::getWeights() const {
+    return weights;
+}
+
+TensorView<const double> Conv2DLayer::getBiases() const {
+    return biases;
+}
+
+void Conv2DLayer::foldScaleAndShift(TensorView<const double> scales, TensorView<const double> shifts) {
+    for (int channel = 0; channel < outputShape.channels; channel++) {
+        for (auto &weight: weights.row(channel)) {
+            weight *= scales[channel];
+        }
+        biases[channel] = biases[channel] * scales[channel] + shifts[channel];
+    }
+}
+
+void Conv2DLayer::computeActivations(TensorView<const double> inputs, TensorView<double> outputs, Arena &arena) const {
+    TensorView<double> columns = arena.allocate<double>({patchSize(), outputPixels()});
+
+    for (long sample = 0; sample < inputs.dim(0); sample++) {
+        im2col(inputs.row(sample).data(), columns);
+
+        //Start from the bias of each channel, then add the kernels times the unrolled image: [channel, pixel]
+        TensorView<double> sampleOutputs = outputs.row(sample).reshape({outputShape.channels, outputPixels()});
+        for (int channel = 0; channel < outputShape.channels; channel++) {
+            sampleOutputs.row(channel).fill(biases[channel]);
+        }
+        gemm(weights, columns, sampleOutputs, true);
+
+        applyActivation(activation, sampleOutputs.data(), outputShape.size());
+    }
+}
+
+void Conv2DLayer::calculateOutputs(TensorView<const double> inputs, Arena &arena) {
+    this->inputs = inputs;
+    activations = arena.allocate<double>({inputs.dim(0), outputShape.size()});
+    computeActivations(inputs, activations, arena);
+}
+
+TensorView<const double> Conv2DLayer::backPropagate(TensorView<const double> outputGradients, Arena &arena,
+                                                    bool needInputGradients) {
+    long batchSize = outputGradients.dim(0);
+
+    //The unrolled images are not kept from the forward pass, at a batch of them they would take more than the rest
+    TensorView<double> columns = arena.allocate<double>({patchSize(), outputPixels()});
+    TensorView<double> gradientProducts = arena.allocate<double>({outputShape.channels, outputPixels()});
+    TensorView<double> columnGradients;
+    TensorView<double> inputGradients;
+    if (needInputGradients) {
+        columnGradients = arena.allocate<double>({patchSize(), outputPixels()});
+        inputGradients = arena.allocate<double>({batchSize, inputShape.size()});
+        inputGradients.fill(0);
+    }
+
+    for (long sample = 0; sample < batchSize; sample++) {
+        //Derivative of the cost with respect to the weighted input of every output pixel
+        multiplyActivationDerivative(activation, activations.row(sample).data(), outputGradients.row(sample).data(),
+                                     gradientProducts.data(), outputShape.size());
+
+        for (int channel = 0; channel < outputShape.channels; channel++) {
+            for (auto &product: gradientProducts.row(channel)) {
+                costGradientB[channel] += product;
+            }
+        }
+
+        //[channel, pixel] x [pixel, patch] adds up this sample's part of the cost gradient of every kernel weight
+        im2col(inputs.row(sample).data(), columns);
+        gemm(gradientProducts, columns.transpose(), costGradientW, true);
+
+        if (needInputGradients) {
+            //[patch, channel] x [channel, pixel] gives the gradient of every unrolled value, folded back onto the image
+            gemm(weights.transpose(), gradientProducts, columnGradients);
+            col2im(columnGradients, inputGradients.row(sample).data());
+        }
+    }
+
+    return inputGradients;
+}
+
+// <-- POOL LAYER IMPLEMENTATION --> //
+
+PoolLayer::PoolLayer(PoolingType type, ImageShape inputShape, int poolSize, int stride) {
+    if (poolSize < 1 || stride < 1 || poolSize > inputShape.height || poolSize > inputShape.width) {
+        throw std::invalid_argument("A pooling needs a window and stride of at least 1, and a window of "
+                                    + std::to_string(poolSize) + " that fits in the image");
+    }
+    this->type = type;
+    this->inputShape = inputShape;
+    this->poolSize = poolSize;
+    this->stride = stride;
+
+    //Windows that would go past the edge of the image are left out
+    outputShape.channels = inputShape.channels;
+    outputShape.height = (inputShape.height - poolSize) / stride + 1;
+    outputShape.width = (inputShape.width - poolSize) / stride + 1;
+}
+
+void PoolLayer::poolSample(const double *image, double *outputs, int *maxIndices) const {
+    double windowArea = static_cast<double>(poolSize) * poolSize;
+    long output = 0;
+
+    for (int channel = 0; channel < inputShape.channels; channel++) {
+        long channelStart = static_cast<long>(channel) * inputShape.height * inputShape.width;
+
+        for (int outY = 0; outY < outputShape.height; outY++) {
+            for (int outX = 0; outX < outputShape.width; outX++) {
+                double maxValue = std::numeric_limits<double>::lowest();
+                double sum = 0;
+                long maxIndex = 0;
+
+                for (int windowY = 0; windowY < poolSize; windowY++) {
+                    long rowStart = channelStart + static_cast<long>(outY * stride + windowY) * inputShape.width;
+                    for (int windowX = 0; windowX < poolSize; windowX++) {
+                        long index = rowStart + outX * stride + windowX;
+                        sum += image[index];
+                        if (image[index] > maxValue) {
+                            maxValue = image[index];
+                            maxIndex = index;
+                        }
+                    }
+                }
+
+                if (type == PoolingType::Max) {
+                    outputs[output] = maxValue;
+                    if (maxIndices != nullptr) {
+                        maxIndices[output] = static_cast<int>(maxIndex);
+                    }
+                } else {
+                    outputs[output] = sum / windowArea;
+                }
+                output++;
+            }
+        }
+    }
+}
+
+long PoolLayer::parameterCount() const {
+    return 0;
+}
+
+void PoolLayer::bindParameters(TensorView<double> parameters, TensorView<double> gradients) {}
+
+void PoolLayer::initializeParameters(std::uint64_t seed) {}
+
+std::size_t PoolLayer::workspaceBytes(long batchSize) const {
+    //Activations and the indices of the maximums, then the gradients of the inputs
+    return Arena::bytesFor<double>(batchSize * outputShape.size()) + Arena::bytesFor<int>(batchSize * outputShape.size())
+           + Arena::bytesFor<double>(batchSize * inputShape.size());
+}
+
+const ImageShape &PoolLayer::getOutputShape() const {
+    return outputShape;
+}
+
+TensorView<const double> PoolLayer::getActivations() const {
+    return activations;
+}
+
+void PoolLayer::computeActivations(TensorView<const double> inputs, TensorView<double> outputs, Arena &arena) const {
+    for (long sample = 0; sample < inputs.dim(0); sample++) {
+        poolSample(inputs.row(sample).data(), outputs.row(sample).data(), nullptr);
+    }
+}
+
+void PoolLayer::calculateOutputs(TensorView<const double> inputs, Arena &arena) {
+    activations = arena.allocate<double>({inputs.dim(0), outputShape.size()});
+    if (type == PoolingType::Max) {
+        maxIndices = arena.allocate<int>({inputs.dim(0), outputShape.size()});
+    }
+
+    for (long sample = 0; sample < inputs.dim(0); sample++) {
+        poolSample(inputs.row(sample).data(), activations.row(sample).data(),
+                   type == PoolingType::Max ? maxIndices.row(sample).data() : nullptr);
+    }
+}
+
+TensorView<const double> PoolLayer::backPropagate(TensorView<const double> outputGradients, Arena &arena,
+                                                  bool needInputGradients) {
+    if (!needInputGradients) {
+        return {};
+    }
+
+    long batchSize = outputGradients.dim(0);
+    TensorView<double> inputGradients = arena.allocate<double>({batchSize, inputShape.size()});
+    inputGradients.fill(0);
+    double windowArea = static_cast<double>(poolSize) * poolSize;
+
+    for (long sample = 0; sample < batchSize; sample++) {
+        const double *sampleGradients = outputGradients.row(sample).data();
+        double *sampleInputGradients = inputGradients.row(sample).data();
+
+        //Max pooling only passes the gradient to the input that was picked, average pooling spreads it evenly
+        if (type == PoolingType::Max) {
+            const int *sampleMaxIndices = maxIndices.row(sample).data();
+            for (long output = 0; output < outputShape.size(); output++) {
+                sampleInputGradients[sampleMaxIndices[output]] += sampleGradients[output];
+            }
+            continue;
+        }
+
+        long output = 0;
+        for (int channel = 0; channel < inputShape.channels; channel++) {
+            long channelStart = static_cast<long>(channel) * inputShape.height * inputShape.width;
+            for (int outY = 0; outY < outputShape.height; outY++) {
+                for (int outX = 0; outX < outputShape.width; outX++) {
+                    double gradient = sampleGradients[output++] / windowArea;
+                    for (int windowY = 0; windowY < poolSize; windowY++) {
+                        double *row = sampleInputGradients + channelStart
+                                      + static_cast<long>(outY * stride + windowY) * inputShape.width + outX * stride;
+                        for (int windowX = 0; windowX < poolSize; windowX++) {
+                            row[windowX] += gradient;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return inputGradients;
+}
+
+// <-- FLATTEN LAYER IMPLEMENTATION --> //
+
+FlattenLayer::FlattenLayer(ImageShape inputShape) {
+    this->inputShape = inputShape;
+}
+
+long FlattenLayer::parameterCount() const {
+    return 0;
+}
+
+void FlattenLayer::bindParameters(TensorView<double> parameters, TensorView<double> gradients) {}
+
+void FlattenLayer::initializeParameters(std::uint64_t seed) {}
+
+std::size_t FlattenLayer::workspaceBytes(long batchSize) const {
+    //The values are handed over as they are
+    return 0;
+}
+
+ImageShape FlattenLayer::getOutputShape() const {
+    return {1, 1, static_cast<int>(inputShape.size())};
+}
+
+TensorView<const double> FlattenLayer::getActivations() const {
+    return activations;
+}
+
+void FlattenLayer::computeActivations(TensorView<const double> inputs, TensorView<double> outputs, Arena &arena) const {
+    outputs.copyFrom(inputs);
+}
+
+void FlattenLayer::calculateOutputs(TensorView<const double> inputs, Arena &arena) {
+    activations = inputs;
+}
+
+TensorView<const double> FlattenLayer::backPropagate(TensorView<const double> outputGradients, Arena &arena,
+                                                     bool needInputGradients) {
+    return outputGradients;
+}
+
+// <-- CONVOLUTION LAYERS IMPLEMENTATION END --> //
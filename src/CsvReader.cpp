@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <vector>
+#include "headers/CsvReader.h"
+#include "headers/MappedFile.h"
+
+using namespace neuralNet;
+
+// <-- HELPER FUNCTIONS --> //
+
+enum class LineKind : std::uint8_t {
+    Sample, Blank, Skipped
+};
+
+//Returns the number of lines in [begin, end), a last line without a line break included
+long countLines(const char *begin, const char *end) {
+    long lines = std::count(begin, end, '\n');
+    return begin != end && end[-1] != '\n' ? lines + 1 : lines;
+}
+
+//Reads a value in [0, maximum) at text, after any spaces, moving text past it. Returns -1 when there is none
+int parseValue(const char *&text, const char *end, int maximum) {
+    while (text != end && *text == ' ') {
+        text++;
+    }
+    int value = -1;
+    auto [next, error] = std::from_chars(text, end, value);
+    if (error != std::errc() || value < 0 || value >= maximum) {
+        return -1;
+    }
+    text = next;
+    return value;
+}
+
+//Parses a line without its line break into the sample, returns what the line turned out to be
+LineKind parseLine(const char *text, const char *end, int inputSize, int numClasses, std::uint8_t *inputs,
+                   int &label) {
+    while (end != text && (end[-1] == '\r' || end[-1] == ' ')) {
+        end--;
+    }
+    if (text == end) {
+        return LineKind::Blank;
+    }
+
+    label = parseValue(text, end, numClasses);
+    if (label < 0) {
+        return LineKind::Skipped;
+    }
+    for (int input = 0; input < inputSize; input++) {
+        if (text == end || *text != ',') {
+            return LineKind::Skipped;
+        }
+        text++;
+        int value = parseValue(text, end, 256);
+        if (value < 0) {
+            return LineKind::Skipped;
+        }
+        inputs[input] = static_cast<std::uint8_t>(value);
+    }
+    return text == end ? LineKind::Sample : LineKind::Skipped;
+}
+
+// <-- CSV READER IMPLEMENTATION --> //
+
+Dataset neuralNet::readCsv(const std::string &path, int inputSize, int numClasses, long *skippedLines,
+                           ThreadPool &pool) {
+    MappedFile file(path);
+    const char *text = reinterpret_cast<const char *>(file.data());
+    const char *textEnd = text + file.size();
+
+    //Every chunk but the first starts right after a line break, so no line is cut in two
+    std::vector<const char *> chunkStarts{text};
+    for (std::size_t offset = csvChunkBytes; offset < file.size(); offset += csvChunkBytes) {
+        const char *start = std::max(text + offset, chunkStarts.back());
+        const char *lineBreak = static_cast<const char *>(std::memchr(start, '\n', textEnd - start));
+        if (lineBreak == nullptr) {
+            break;
+        }
+        chunkStarts.push_back(lineBreak + 1);
+    }
+    chunkStarts.push_back(textEnd);
+    long chunks = static_cast<long>(chunkStarts.size()) - 1;
+
+    //The lines are counted first, so every chunk knows the index of its first line and can write to its samples
+    std::vector<long> firstLines(chunks + 1, 0);
+    pool.parallelFor(0, chunks, 1, [&](long begin, long end) {
+        for (long chunk = begin; chunk < end; chunk++) {
+            firstLines[chunk + 1] = countLines(chunkStarts[chunk], chunkStarts[chunk + 1]);
+        }
+    });
+    for (long chunk = 0; chunk < chunks; chunk++) {
+        firstLines[chunk + 1] += firstLines[chunk];
+    }
+
+    Dataset dataset(inputSize, numClasses);
+    dataset.resize(static_cast<int>(firstLines.back()));
+    std::vector<LineKind> kinds(firstLines.back());
+    pool.parallelFor(0, chunks, 1, [&](long begin, long end) {
+        for (long chunk = begin; chunk < end; chunk++) {
+            long line = firstLines[chunk];
+            for (const char *lineStart = chunkStarts[chunk]; lineStart < chunkStarts[chunk + 1]; line++) {
+                const char *lineEnd = std::find(lineStart, chunkStarts[chunk + 1], '\n');
+                int label = 0;
+                kinds[line] = parseLine(lineStart, lineEnd, inputSize, numClasses,
+                                        dataset.mutableSample(static_cast<int>(line)), label);
+                if (kinds[line] == LineKind::Sample) {
+                    dataset.setLabel(static_cast<int>(line), label);
+                }
+                lineStart = lineEnd + 1;
+            }
+        }
+    });
+
+    //Moves the samples after the lines left out down over them, which only happens for the few that are not samples
+    int samples = 0;
+    long skipped = 0;
+    for (long line = 0; line < kinds.size(); line++) {
+        if (kinds[line] != LineKind::Sample) {
+            skipped += kinds[line] == LineKind::Skipped;
+            continue;
+        }
+        if (samples != line) {
+            std::memcpy(dataset.mutableSample(samples), dataset.sample(static_cast<int>(line)), inputSize);
+            dataset.setLabel(samples, dataset.label(static_cast<int>(line)));
+        }
+        samples++;
+    }
+    dataset.resize(samples);
+    if (skippedLines != nullptr) {
+        *skippedLines = skipped;
+    }
+    return dataset;
+}
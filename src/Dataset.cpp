@@ -0,0 +1,150 @@
+#include "headers/Dataset.h"
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace neuralNet;
+
+// <-- BATCH IMPLEMENTATION --> //
+
+void Batch::reshape(int count, int inputSize, int numClasses) {
+    if (inputs.rank() != 2 || inputs.dim(0) != count || inputs.dim(1) != inputSize) {
+        inputs = Tensor<double>({count, inputSize});
+    }
+    if (expectedOutputs.rank() != 2 || expectedOutputs.dim(0) != count || expectedOutputs.dim(1) != numClasses) {
+        expectedOutputs = Tensor<double>({count, numClasses});
+    }
+    labels.resize(count);
+}
+
+void Batch::setSample(int row, const std::uint8_t *sampleInputs, double inputScale, int label) {
+    if (label < 0 || label >= expectedOutputs.dim(1)) {
+        throw std::out_of_range("Label " + std::to_string(label) + " is not one of the "
+                                + std::to_string(expectedOutputs.dim(1)) + " classes");
+    }
+
+    //Convert the inputs to doubles on the way into the batch
+    double *target = inputs.row(row).data();
+    for (long input = 0; input < inputs.dim(1); input++) {
+        target[input] = sampleInputs[input] * inputScale;
+    }
+
+    //The row of expected outputs is all 0, set the correct node to activation 1
+    labels[row] = label;
+    expectedOutputs(row, label) = 1;
+}
+
+// <-- DATASET IMPLEMENTATION --> //
+
+Dataset::Dataset(int inputSize, int numClasses, double inputScale) {
+    this->inputSize = inputSize;
+    this->numClasses = numClasses;
+    this->inputScale = inputScale;
+}
+
+Dataset Dataset::view(int inputSize, int numClasses, const std::uint8_t *inputs, std::vector<int> labels,
+                      std::shared_ptr<const void> storage, double inputScale) {
+    for (int label: labels) {
+        if (label < 0 || label >= numClasses) {
+            throw std::out_of_range("Dataset label " + std::to_string(label) + " is not a valid class");
+        }
+    }
+
+    Dataset dataset(inputSize, numClasses, inputScale);
+    dataset.labels = std::move(labels);
+    dataset.viewedInputs = inputs;
+    dataset.viewedStorage = std::move(storage);
+    return dataset;
+}
+
+void Dataset::ownInputs() {
+    if (viewedInputs != nullptr) {
+        inputs.assign(viewedInputs, viewedInputs + static_cast<std::size_t>(labels.size()) * inputSize);
+        viewedInputs = nullptr;
+        viewedStorage.reset();
+    }
+}
+
+void Dataset::reserve(int samples) {
+    ownInputs();
+    inputs.reserve(static_cast<std::size_t>(samples) * inputSize);
+    labels.reserve(samples);
+}
+
+void Dataset::add(const std::uint8_t *sampleInputs, int label) {
+    if (label < 0 || label >= numClasses) {
+        throw std::out_of_range("Dataset label " + std::to_string(label) + " is not a valid class");
+    }
+    ownInputs();
+    inputs.insert(inputs.end(), sampleInputs, sampleInputs + inputSize);
+    labels.push_back(label);
+}
+
+void Dataset::resize(int samples) {
+    ownInputs();
+    inputs.resize(static_cast<std::size_t>(samples) * inputSize);
+    labels.resize(samples);
+}
+
+void Dataset::setLabel(int index, int label) {
+    if (label < 0 || label >= numClasses) {
+        throw std::out_of_range("Dataset label " + std::to_string(label) + " is not a valid class");
+    }
+    labels[index] = label;
+}
+
+int Dataset::size() const {
+    return static_cast<int>(labels.size());
+}
+
+int Dataset::sampleSize() const {
+    return inputSize;
+}
+
+int Dataset::classes() const {
+    return numClasses;
+}
+
+double Dataset::scale() const {
+    return inputScale;
+}
+
+const std::uint8_t *Dataset::sample(int index) const {
+    const std::uint8_t *data = viewedInputs != nullptr ? viewedInputs : inputs.data();
+    return data + static_cast<std::size_t>(index) * inputSize;
+}
+
+std::uint8_t *Dataset::mutableSample(int index) {
+    ownInputs();
+    return &inputs[static_cast<std::size_t>(index) * inputSize];
+}
+
+int Dataset::label(int index) const {
+    return labels[index];
+}
+
+bool Dataset::isView() const {
+    return viewedInputs != nullptr;
+}
+
+std::size_t Dataset::memoryUsage() const {
+    return labels.size() * (static_cast<std::size_t>(inputSize) * sizeof(std::uint8_t) + sizeof(int));
+}
+
+void Dataset::loadBatch(int start, int count, Batch &batch) const {
+    std::vector<int> indices(count);
+    for (int index = 0; index < count; index++) {
+        indices[index] = start + index;
+    }
+    loadBatch(indices, batch);
+}
+
+void Dataset::loadBatch(const std::vector<int> &indices, Batch &batch) const {
+    int count = static_cast<int>(indices.size());
+    batch.reshape(count, inputSize, numClasses);
+    batch.expectedOutputs.fill(0);
+
+    for (int row = 0; row < count; row++) {
+        batch.setSample(row, sample(indices[row]), inputScale, labels[indices[row]]);
+    }
+}
@@ -0,0 +1,184 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include "headers/DatasetCache.h"
+#include "headers/MappedFile.h"
+#include "headers/Random.h"
+#include "headers/Tensor.h"
+
+using namespace neuralNet;
+
+// <-- HELPER FUNCTIONS --> //
+
+//Identifies cache files, and their version: a cache with another layout is simply written again
+constexpr std::uint64_t cacheMagic = 0x4E4E434143484532ull;
+
+//Words a hash lane takes at a time, the lanes being independent so their multiplications overlap
+constexpr int hashLanes = 4;
+
+struct CacheHeader {
+    std::uint64_t magic;
+
+    //What the source was when the cache was written
+    std::uint64_t sourceSize;
+    std::int64_t sourceModified;
+    std::uint64_t sourceHash;
+
+    //How it was loaded
+    std::int32_t inputSize;
+    std::int32_t numClasses;
+    double inputScale;
+
+    std::int64_t sampleCount;
+};
+
+//The labels follow the header and the inputs start on the next cache line, so they can be read in place
+std::size_t inputsOffset(std::int64_t sampleCount) {
+    std::size_t labelsEnd = sizeof(CacheHeader) + sampleCount * sizeof(std::int32_t);
+    return (labelsEnd + tensorAlignment - 1) / tensorAlignment * tensorAlignment;
+}
+
+//Hashes the whole source a 64 bit word per lane at a time, which runs at memory speed
+std::uint64_t hashContent(const std::uint8_t *data, std::size_t size) {
+    constexpr std::uint64_t prime = 0x9E3779B97F4A7C15ull;
+    std::uint64_t lanes[hashLanes] = {1, 2, 3, 4};
+    std::size_t blockBytes = hashLanes * sizeof(std::uint64_t);
+    std::size_t position = 0;
+    for (; position + blockBytes <= size; position += blockBytes) {
+        std::uint64_t words[hashLanes];
+        std::memcpy(words, data + position, blockBytes);
+        for (int lane = 0; lane < hashLanes; lane++) {
+            lanes[lane] = (lanes[lane] ^ words[lane]) * prime;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+
+    std::uint64_t hash = size;
+    for (; position < size; position++) {
+        hash = (hash ^ data[position]) * prime;
+    }
+    for (auto lane: lanes) {
+        hash = mixSeed(hash, lane);
+    }
+    return hash;
+}
+
+//Returns what a cache of the source must hold in its header to be used
+CacheHeader expectedHeader(const std::string &sourcePath, int inputSize, int numClasses, double inputScale) {
+    MappedFile source(sourcePath);
+    CacheHeader header{};
+    header.magic = cacheMagic;
+    header.sourceSize = source.size();
+    header.sourceModified = std::filesystem::last_write_time(sourcePath).time_since_epoch().count();
+    header.sourceHash = hashContent(source.data(), source.size());
+    header.inputSize = inputSize;
+    header.numClasses = numClasses;
+    header.inputScale = inputScale;
+    return header;
+}
+
+//Returns true and sets the dataset when the cache exists and was written for the expected header
+bool readCache(const std::string &path, const CacheHeader &expected, Dataset &dataset) {
+    std::error_code error;
+    if (!std::filesystem::exists(path, error)) {
+        return false;
+    }
+    std::shared_ptr<MappedFile> cache;
+    try {
+        cache = std::make_shared<MappedFile>(path);
+    } catch (const std::runtime_error &) {
+        return false;
+    }
+
+    CacheHeader header{};
+    if (cache->size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, cache->data(), sizeof(header));
+    if (header.magic != expected.magic || header.sourceSize != expected.sourceSize
+        || header.sourceModified != expected.sourceModified || header.sourceHash != expected.sourceHash
+        || header.inputSize != expected.inputSize || header.numClasses != expected.numClasses
+        || header.inputScale != expected.inputScale || header.sampleCount < 0
+        || cache->size() != inputsOffset(header.sampleCount) + header.sampleCount * header.inputSize) {
+        return false;
+    }
+
+    std::vector<int> labels(header.sampleCount);
+    std::memcpy(labels.data(), cache->data() + sizeof(header), labels.size() * sizeof(std::int32_t));
+
+    //A corrupt label makes the cache unusable like a wrong header, it is written again rather than failing the load
+    for (int label: labels) {
+        if (label < 0 || label >= header.numClasses) {
+            return false;
+        }
+    }
+    const std::uint8_t *inputs = cache->data() + inputsOffset(header.sampleCount);
+    dataset = Dataset::view(header.inputSize, header.numClasses, inputs, std::move(labels), std::move(cache),
+                            header.inputScale);
+    return true;
+}
+
+//Writes the cache through a temporary file, returns false when it could not be written
+bool writeCache(const std::string &path, CacheHeader header, const Dataset &dataset) {
+    std::string temporaryPath = path + ".tmp";
+    header.sampleCount = dataset.size();
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        for (int sample = 0; sample < dataset.size(); sample++) {
+            auto label = static_cast<std::int32_t>(dataset.label(sample));
+            file.write(reinterpret_cast<const char *>(&label), sizeof(label));
+        }
+        std::size_t padding = inputsOffset(header.sampleCount) - sizeof(header)
+                              - header.sampleCount * sizeof(std::int32_t);
+        file.write(std::string(padding, '\0').data(), static_cast<std::streamsize>(padding));
+
+        //The inputs of a dataset that owns them are contiguous, a view's too
+        if (dataset.size() > 0) {
+            file.write(reinterpret_cast<const char *>(dataset.sample(0)),
+                       static_cast<std::streamsize>(dataset.size()) * dataset.sampleSize());
+        }
+        if (!file) {
+            file.close();
+            std::error_code error;
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
+
+// <-- DATASET CACHE IMPLEMENTATION --> //
+
+std::string neuralNet::cachePath(const std::string &sourcePath) {
+    return sourcePath + ".nncache";
+}
+
+Dataset neuralNet::loadWithCache(const std::string &sourcePath, int inputSize, int numClasses,
+                                 const std::function<Dataset()> &load, double inputScale, bool *cacheHit) {
+    CacheHeader expected = expectedHeader(sourcePath, inputSize, numClasses, inputScale);
+    std::string path = cachePath(sourcePath);
+
+    Dataset dataset(inputSize, numClasses, inputScale);
+    bool hit = readCache(path, expected, dataset);
+    if (!hit) {
+        dataset = load();
+        if (dataset.sampleSize() == inputSize && dataset.classes() == numClasses && dataset.scale() == inputScale) {
+            writeCache(path, expected, dataset);
+        }
+    }
+    if (cacheHit != nullptr) {
+        *cacheHit = hit;
+    }
+    return dataset;
+}
@@ -0,0 +1,387 @@
+#include "headers/DenseLayer.h"
+#include "headers/Gemm.h"
+#include <algorithm>
+#include <iostream>
+
+using namespace neuralNet;
+
+// <-- DENSE LAYER IMPLEMENTATION --> //
+
+DenseLayer::DenseLayer(int numNodesIn, int numNodesOut, ActivationFunction activation, InitScheme initialization) {
+    this->numNodesIn = numNodesIn;
+    this->numNodesOut = numNodesOut;
+    this->activation = activation;
+    this->initialization = initialization == InitScheme::Default ? InitScheme::Gaussian : initialization;
+
+    /* Both kernels do numNodesOut multiply-adds per input they use, but the sparse one also has to build the
+       compressed inputs and jump between weight rows, which costs about as much as a few more multiply-adds
+       per input. Narrow layers have less work per input to hide that behind, so they switch later */
+    double sparseOverheadPerInput = 4.0;
+    sparseDensityThreshold = std::clamp(1.0 - sparseOverheadPerInput / numNodesOut, 0.0, 0.75);
+
+    acrossSamples = numNodesOut < vectorWidth * acrossSamplesWidthFactor;
+}
+
+long DenseLayer::parameterCount() const {
+    return static_cast<long>(numNodesIn + 1) * numNodesOut;
+}
+
+void DenseLayer::bindParameters(TensorView<double> parameters, TensorView<double> gradients) {
+    //The weights come first, one row per incoming node, then the biases
+    long weightCount = static_cast<long>(numNodesIn) * numNodesOut;
+    weights = parameters.slice(0, weightCount).reshape({numNodesIn, numNodesOut});
+    biases = parameters.slice(weightCount, parameterCount());
+    costGradientW = gradients.slice(0, weightCount).reshape({numNodesIn, numNodesOut});
+    costGradientB = gradients.slice(weightCount, parameterCount());
+}
+
+std::size_t DenseLayer::workspaceBytes(long batchSize) const {
+    //Activations, compressed inputs when there are few enough non zero ones, gradient products and input gradients
+    long maxNonZero = static_cast<long>(sparseDensityThreshold * batchSize * numNodesIn);
+    std::size_t bytes = Arena::bytesFor<double>(batchSize * numNodesOut)
+                        + Arena::bytesFor<int>(batchSize + 1) + Arena::bytesFor<int>(maxNonZero)
+                        + Arena::bytesFor<double>(maxNonZero)
+                        + Arena::bytesFor<double>(batchSize * numNodesOut)
+                        + Arena::bytesFor<double>(batchSize * numNodesIn);
+
+    //The across samples kernels keep transposed copies of the inputs, outputs and both gradients
+    if (acrossSamples) {
+        bytes += 2 * Arena::bytesFor<double>(batchSize * numNodesIn)
+                 + 2 * Arena::bytesFor<double>(batchSize * numNodesOut);
+    }
+    return bytes;
+}
+
+void DenseLayer::initializeParameters(std::uint64_t seed) {
+    initializeWeights(initialization, weights, biases, numNodesIn, numNodesOut, seed);
+}
+
+void DenseLayer::calculateOutputs(TensorView<const double> inputs, Arena &arena) {
+    this->inputs = inputs;
+    activations = arena.allocate<double>({inputs.dim(0), numNodesOut});
+
+    //Pixel inputs are mostly 0, in which case only the weight rows of the non zero inputs are needed
+    inputsAreSparse = compressInputs(inputs, arena);
+
+    //A batch smaller than a vector has nothing to gain from putting the samples in the vector lanes
+    batchAcrossSamples = !inputsAreSparse && acrossSamples && inputs.dim(0) >= vectorWidth;
+
+    if (inputsAreSparse) {
+        computeSparseActivations(sparseInputs, activations);
+    } else if (batchAcrossSamples) {
+        transposedInputs = arena.allocate<double>({numNodesIn, inputs.dim(0)});
+        transposedInputs.copyFrom(inputs.transpose());
+        computeActivationsAcrossSamples(transposedInputs, activations, arena);
+    } else {
+        computeActivations(inputs, activations, arena);
+    }
+}
+
+bool DenseLayer::compressInputs(TensorView<const double> inputs, Arena &arena) {
+    //Count the non zero inputs, giving up as soon as there are too many for the sparse kernels to be worth it
+    long maxNonZero = static_cast<long>(sparseDensityThreshold * inputs.size());
+    long nonZero = 0;
+    for (long sample = 0; sample < inputs.dim(0); sample++) {
+        const double *sampleInputs = inputs.row(sample).data();
+        for (int nodeIn = 0; nodeIn < numNodesIn; nodeIn++) {
+            nonZero += sampleInputs[nodeIn] != 0;
+        }
+        if (nonZero > maxNonZero) {
+            return false;
+        }
+    }
+
+    sparseInputs.rowStarts = arena.allocate<int>({inputs.dim(0) + 1});
+    sparseInputs.columns = arena.allocate<int>({nonZero});
+    sparseInputs.values = arena.allocate<double>({nonZero});
+
+    int entry = 0;
+    for (long sample = 0; sample < inputs.dim(0); sample++) {
+        sparseInputs.rowStarts[sample] = entry;
+        const double *sampleInputs = inputs.row(sample).data();
+        for (int nodeIn = 0; nodeIn < numNodesIn; nodeIn++) {
+            if (sampleInputs[nodeIn] != 0) {
+                sparseInputs.columns[entry] = nodeIn;
+                sparseInputs.values[entry] = sampleInputs[nodeIn];
+                entry++;
+            }
+        }
+    }
+    sparseInputs.rowStarts[inputs.dim(0)] = entry;
+    return true;
+}
+
+void DenseLayer::foldScaleAndShift(TensorView<const double> scales, TensorView<const double> shifts) {
+    for (int nodeIn = 0; nodeIn < numNodesIn; nodeIn++) {
+        for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+            weights(nodeIn, nodeOut) *= scales[nodeOut];
+        }
+    }
+    for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+        biases[nodeOut] = biases[nodeOut] * scales[nodeOut] + shifts[nodeOut];
+    }
+}
+
+void DenseLayer::computeActivations(TensorView<const double> inputs, TensorView<double> outputs,
+                                    Arena &arena) const {
+    //Start every sample from the bias of each node
+    for (long sample = 0; sample < inputs.dim(0); sample++) {
+        std::copy(biases.begin(), biases.end(), outputs.row(sample).data());
+    }
+
+    /* Add the activations of the previous layer times the weights of their connections to the nodes of this layer,
+       [sample, nodeIn] x [nodeIn, nodeOut]. Formula ends up being: b + a1 * w1 + a2 * w2 + ... */
+    gemm(inputs, weights, outputs, true);
+
+    for (long sample = 0; sample < outputs.dim(0); sample++) {
+        applyActivation(activation, outputs.row(sample).data(), numNodesOut);
+    }
+}
+
+void DenseLayer::computeSparseActivations(const SparseInputs &inputs, TensorView<double> outputs) const {
+    for (long sample = 0; sample < outputs.dim(0); sample++) {
+        double *weightedInputs = outputs.row(sample).data();
+        std::copy(biases.begin(), biases.end(), weightedInputs);
+
+        //Same as computeActivations, but the inputs that are 0 would not add anything, so they are skipped
+        for (int entry = inputs.rowStarts[sample]; entry < inputs.rowStarts[sample + 1]; entry++) {
+            double input = inputs.values[entry];
+            const double *weightRow = weights.row(inputs.columns[entry]).data();
+            for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+                weightedInputs[nodeOut] += input * weightRow[nodeOut];
+            }
+        }
+
+        applyActivation(activation, weightedInputs, numNodesOut);
+    }
+}
+
+void DenseLayer::computeActivationsAcrossSamples(TensorView<const double> transposedInputs, TensorView<double> outputs,
+                                                 Arena &arena) const {
+    long batchSize = transposedInputs.dim(1);
+    TensorView<double> weightedInputs = arena.allocate<double>({numNodesOut, batchSize});
+
+    for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+        weightedInputs.row(nodeOut).fill(biases[nodeOut]);
+    }
+
+    //Same formula as computeActivations, but every weight is multiplied by a whole row of samples at once
+    for (int nodeIn = 0; nodeIn < numNodesIn; nodeIn++) {
+        const double *inputRow = transposedInputs.row(nodeIn).data();
+        for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+            double weight = weights(nodeIn, nodeOut);
+            double *weightedRow = weightedInputs.row(nodeOut).data();
+            for (long sample = 0; sample < batchSize; sample++) {
+                weightedRow[sample] += weight * inputRow[sample];
+            }
+        }
+    }
+
+    for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+        applyActivation(activation, weightedInputs.row(nodeOut).data(), batchSize);
+    }
+    outputs.copyFrom(weightedInputs.transpose());
+}
+
+int DenseLayer::length() const {
+    return numNodesOut;
+}
+
+int DenseLayer::nodesIn() const {
+    return numNodesIn;
+}
+
+void DenseLayer::setSparseDensityThreshold(double threshold) {
+    sparseDensityThreshold = threshold;
+}
+
+double DenseLayer::getSparseDensityThreshold() const {
+    return sparseDensityThreshold;
+}
+
+void DenseLayer::setAcrossSamples(bool enabled) {
+    acrossSamples = enabled;
+}
+
+bool DenseLayer::getAcrossSamples() const {
+    return acrossSamples;
+}
+
+ImageShape DenseLayer::getOutputShape() const {
+    return {1, 1, numNodesOut};
+}
+
+ActivationFunction DenseLayer::getActivationFunction() const {
+    return activation;
+}
+
+TensorView<const double> DenseLayer::getActivations() const {
+    return activations;
+}
+
+TensorView<const double> DenseLayer::getWeights() const {
+    return weights;
+}
+
+TensorView<const double> DenseLayer::getBiases() const {
+    return biases;
+}
+
+void DenseLayer::printNodes() const {
+    for (int nodeIn = 0; nodeIn < numNodesIn; nodeIn++) {
+        for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+            std::cout << "Node in: " << nodeIn << ", Node out: " << nodeOut << ", Value: " << weights(nodeIn, nodeOut)
+                      << std::endl;
+        }
+    }
+}
+
+TensorView<const double> DenseLayer::backPropagate(TensorView<const double> outputGradients, Arena &arena,
+                                                   bool needInputGradients) {
+    long batchSize = outputGradients.dim(0);
+
+    //Evaluate partial derivatives for every node: cost/activation * activation/weightedInput
+    TensorView<double> gradientProducts = arena.allocate<double>({batchSize, numNodesOut});
+    for (long sample = 0; sample < batchSize; sample++) {
+        multiplyActivationDerivative(activation, activations.row(sample).data(), outputGradients.row(sample).data(),
+                                     gradientProducts.row(sample).data(), numNodesOut);
+    }
+
+    if (batchAcrossSamples) {
+        return backPropagateAcrossSamples(gradientProducts, arena, needInputGradients);
+    }
+
+    //The first layer has no layer before it, so it only needs its own gradients
+    if (!needInputGradients) {
+        calculateGradients(gradientProducts);
+        return {};
+    }
+
+    TensorView<double> inputGradients = arena.allocate<double>({batchSize, numNodesIn});
+
+    for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+        double biasGradient = 0;
+        for (long sample = 0; sample < batchSize; sample++) {
+            biasGradient += gradientProducts(sample, nodeOut);
+        }
+        costGradientB[nodeOut] += biasGradient;
+    }
+
+    /* The rows of weights are visited in tiles, and for each tile the samples are visited in tiles as well. A tile
+       of weight and gradient rows stays in the cache while every sample goes through it, and a tile of gradient
+       products stays in the cache while a tile of rows goes through it, so each row is only loaded once */
+    int rowTile = std::max(1, static_cast<int>(backPropagationTileBytes / (2 * numNodesOut * sizeof(double))));
+    long sampleTile = std::max(1L, static_cast<long>(backPropagationTileBytes / (numNodesOut * sizeof(double))));
+
+    for (int firstRow = 0; firstRow < numNodesIn; firstRow += rowTile) {
+        int lastRow = std::min(numNodesIn, firstRow + rowTile);
+
+        for (long firstSample = 0; firstSample < batchSize; firstSample += sampleTile) {
+            long lastSample = std::min(batchSize, firstSample + sampleTile);
+
+            for (int nodeIn = firstRow; nodeIn < lastRow; nodeIn++) {
+                const double *weightRow = weights.row(nodeIn).data();
+                double *gradientRow = costGradientW.row(nodeIn).data();
+
+                for (long sample = firstSample; sample < lastSample; sample++) {
+                    const double *sampleProducts = gradientProducts.row(sample).data();
+                    double input = inputs(sample, nodeIn);
+
+                    /* In the same pass over the row: add up the weighted gradient products for the input node,
+                       and add this sample's part of the cost gradient of each weight */
+                    double weightedGradient = 0;
+                    for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+                        weightedGradient += weightRow[nodeOut] * sampleProducts[nodeOut];
+                        gradientRow[nodeOut] += input * sampleProducts[nodeOut];
+                    }
+                    inputGradients(sample, nodeIn) = weightedGradient;
+                }
+            }
+        }
+    }
+
+    return inputGradients;
+}
+
+TensorView<const double> DenseLayer::backPropagateAcrossSamples(TensorView<const double> gradientProducts,
+                                                                Arena &arena, bool needInputGradients) {
+    long batchSize = gradientProducts.dim(0);
+    TensorView<double> transposedProducts = arena.allocate<double>({numNodesOut, batchSize});
+    transposedProducts.copyFrom(gradientProducts.transpose());
+
+    for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+        const double *productRow = transposedProducts.row(nodeOut).data();
+        double biasGradient = 0;
+        for (long sample = 0; sample < batchSize; sample++) {
+            biasGradient += productRow[sample];
+        }
+        costGradientB[nodeOut] += biasGradient;
+    }
+
+    //The cost gradient of a weight adds up its input times its gradient product over the batch, a dot product of rows
+    for (int nodeIn = 0; nodeIn < numNodesIn; nodeIn++) {
+        const double *inputRow = transposedInputs.row(nodeIn).data();
+        double *gradientRow = costGradientW.row(nodeIn).data();
+        for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+            const double *productRow = transposedProducts.row(nodeOut).data();
+            double weightGradient = 0;
+            for (long sample = 0; sample < batchSize; sample++) {
+                weightGradient += inputRow[sample] * productRow[sample];
+            }
+            gradientRow[nodeOut] += weightGradient;
+        }
+    }
+
+    if (!needInputGradients) {
+        return {};
+    }
+
+    //Add up the weighted gradient products of every input node as [nodeIn, sample], then transpose them back
+    TensorView<double> transposedInputGradients = arena.allocate<double>({numNodesIn, batchSize});
+    TensorView<double> inputGradients = arena.allocate<double>({batchSize, numNodesIn});
+    transposedInputGradients.fill(0);
+    for (int nodeIn = 0; nodeIn < numNodesIn; nodeIn++) {
+        double *inputGradientRow = transposedInputGradients.row(nodeIn).data();
+        for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+            double weight = weights(nodeIn, nodeOut);
+            const double *productRow = transposedProducts.row(nodeOut).data();
+            for (long sample = 0; sample < batchSize; sample++) {
+                inputGradientRow[sample] += weight * productRow[sample];
+            }
+        }
+    }
+    inputGradients.copyFrom(transposedInputGradients.transpose());
+    return inputGradients;
+}
+
+void DenseLayer::calculateGradients(TensorView<const double> gradientProducts) {
+    //Add up the gradients of every sample in the batch
+    for (long sample = 0; sample < gradientProducts.dim(0); sample++) {
+        const double *sampleGradients = gradientProducts.row(sample).data();
+
+        if (inputsAreSparse) {
+            //Inputs that are 0 leave the gradient of their weights unchanged, so only the non zero ones are visited
+            for (int entry = sparseInputs.rowStarts[sample]; entry < sparseInputs.rowStarts[sample + 1]; entry++) {
+                double input = sparseInputs.values[entry];
+                double *gradientRow = costGradientW.row(sparseInputs.columns[entry]).data();
+                for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+                    gradientRow[nodeOut] += input * sampleGradients[nodeOut];
+                }
+            }
+        } else {
+            for (int nodeIn = 0; nodeIn < numNodesIn; nodeIn++) {
+                double input = inputs(sample, nodeIn);
+                double *gradientRow = costGradientW.row(nodeIn).data();
+                for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+                    gradientRow[nodeOut] += input * sampleGradients[nodeOut];
+                }
+            }
+        }
+
+        for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
+            costGradientB[nodeOut] += sampleGradients[nodeOut];
+        }
+    }
+}
+
+// <-- DENSE LAYER IMPLEMENTATION END --> //
@@ -0,0 +1,279 @@
+#include "headers/DigitCanvas.h"
+#include "headers/Visualizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// <-- DIGIT CANVAS IMPLEMENTATION --> //
+
+void DigitCanvas::attach(neuralNet::NeuralNetwork *network) {
+    release();
+    this->network = network;
+
+    //The canvas only makes sense for square image inputs
+    int nodesIn = static_cast<int>(network->inputSize());
+    side = static_cast<int>(std::lround(std::sqrt(static_cast<double>(nodesIn))));
+    if (side * side != nodesIn) {
+        side = 0;
+        return;
+    }
+
+    canvasSide = side * scale;
+    canvas.assign(static_cast<size_t>(canvasSide) * canvasSide, 0);
+    inputs = neuralNet::Tensor<double>({nodesIn});
+    latencies.assign(240, 0);
+    latencyIndex = 0;
+    classifications = 0;
+    clear();
+}
+
+void DigitCanvas::clear() {
+    std::fill(canvas.begin(), canvas.end(), 0.0f);
+    inputs.fill(0);
+    outputs = neuralNet::Tensor<double>();
+    prediction = -1;
+    dirty = true;
+}
+
+void DigitCanvas::paintDot(ImVec2 center) {
+    int minX = std::max(0, static_cast<int>(center.x - brushRadius));
+    int maxX = std::min(canvasSide - 1, static_cast<int>(center.x + brushRadius));
+    int minY = std::max(0, static_cast<int>(center.y - brushRadius));
+    int maxY = std::min(canvasSide - 1, static_cast<int>(center.y + brushRadius));
+
+    for (int y = minY; y <= maxY; y++) {
+        for (int x = minX; x <= maxX; x++) {
+            float dx = x + 0.5f - center.x;
+            float dy = y + 0.5f - center.y;
+            float distance = std::sqrt(dx * dx + dy * dy) / brushRadius;
+
+            //Full intensity in the middle of the brush, fading out on the last third of its radius
+            float intensity = std::clamp((1.0f - distance) * 3.0f, 0.0f, 1.0f);
+            float &pixel = canvas[static_cast<size_t>(y) * canvasSide + x];
+            pixel = std::max(pixel, intensity);
+        }
+    }
+}
+
+void DigitCanvas::paintLine(ImVec2 from, ImVec2 to) {
+    float dx = to.x - from.x;
+    float dy = to.y - from.y;
+    float length = std::sqrt(dx * dx + dy * dy);
+
+    //Place a dab every quarter of the brush radius, so fast strokes do not leave gaps
+    int steps = std::max(1, static_cast<int>(length / (brushRadius * 0.25f)));
+    for (int step = 0; step <= steps; step++) {
+        float t = static_cast<float>(step) / steps;
+        paintDot(ImVec2(from.x + dx * t, from.y + dy * t));
+    }
+}
+
+void DigitCanvas::downsample() {
+    //Average each scale x scale block of the canvas into one input
+    for (int y = 0; y < side; y++) {
+        for (int x = 0; x < side; x++) {
+            float sum = 0;
+            for (int blockY = 0; blockY < scale; blockY++) {
+                const float *row = &canvas[static_cast<size_t>(y * scale + blockY) * canvasSide + x * scale];
+                for (int blockX = 0; blockX < scale; blockX++) {
+                    sum += row[blockX];
+                }
+            }
+            inputs[y * side + x] = sum / (scale * scale);
+        }
+    }
+
+    if (!centerDigit) {
+        return;
+    }
+
+    //MNIST digits are centered on their center of mass, so move the drawing there as well
+    double mass = 0, centerX = 0, centerY = 0;
+    for (int y = 0; y < side; y++) {
+        for (int x = 0; x < side; x++) {
+            mass += inputs[y * side + x];
+            centerX += inputs[y * side + x] * x;
+            centerY += inputs[y * side + x] * y;
+        }
+    }
+    if (mass == 0) {
+        return;
+    }
+
+    int shiftX = static_cast<int>(std::lround((side - 1) / 2.0 - centerX / mass));
+    int shiftY = static_cast<int>(std::lround((side - 1) / 2.0 - centerY / mass));
+    if (shiftX == 0 && shiftY == 0) {
+        return;
+    }
+
+    neuralNet::Tensor<double> shifted({inputs.size()});
+    for (int y = 0; y < side; y++) {
+        for (int x = 0; x < side; x++) {
+            int targetX = x + shiftX;
+            int targetY = y + shiftY;
+            if (targetX >= 0 && targetX < side && targetY >= 0 && targetY < side) {
+                shifted[targetY * side + targetX] = inputs[y * side + x];
+            }
+        }
+    }
+    inputs = std::move(shifted);
+}
+
+void DigitCanvas::classify() {
+    auto start = std::chrono::steady_clock::now();
+    downsample();
+    outputs = network->predict(inputs);
+    auto end = std::chrono::steady_clock::now();
+
+    prediction = static_cast<int>(std::max_element(outputs.begin(), outputs.end()) - outputs.begin());
+
+    latencies[latencyIndex] = std::chrono::duration<float, std::micro>(end - start).count();
+    latencyIndex = (latencyIndex + 1) % static_cast<int>(latencies.size());
+    classifications++;
+}
+
+void DigitCanvas::uploadTextures() {
+    if (canvasTexture == 0) {
+        canvasTexture = createImageTexture(canvasSide, canvasSide);
+        inputsTexture = createImageTexture(side, side);
+    }
+
+    pixels.resize(static_cast<size_t>(canvasSide) * canvasSide * 4);
+    for (size_t pixel = 0; pixel < canvas.size(); pixel++) {
+        auto intensity = static_cast<unsigned char>(canvas[pixel] * 255.0f);
+        pixels[pixel * 4] = intensity;
+        pixels[pixel * 4 + 1] = intensity;
+        pixels[pixel * 4 + 2] = intensity;
+        pixels[pixel * 4 + 3] = 255;
+    }
+    uploadImageTexture(canvasTexture, canvasSide, canvasSide, pixels.data());
+
+    for (size_t pixel = 0; pixel < inputs.size(); pixel++) {
+        auto intensity = static_cast<unsigned char>(std::clamp(inputs[pixel], 0.0, 1.0) * 255.0);
+        pixels[pixel * 4] = intensity;
+        pixels[pixel * 4 + 1] = intensity;
+        pixels[pixel * 4 + 2] = intensity;
+        pixels[pixel * 4 + 3] = 255;
+    }
+    uploadImageTexture(inputsTexture, side, side, pixels.data());
+    dirty = false;
+}
+
+void DigitCanvas::drawLatencyStats() {
+    int count = static_cast<int>(std::min<long>(classifications, static_cast<long>(latencies.size())));
+    if (count == 0) {
+        ImGui::TextUnformatted("No classifications yet");
+        return;
+    }
+
+    //Percentiles over the samples still in the ring buffer
+    std::vector<float> sorted(latencies.begin(), latencies.begin() + count);
+    std::sort(sorted.begin(), sorted.end());
+    float mean = 0;
+    for (auto &latency: sorted) {
+        mean += latency;
+    }
+    mean /= count;
+
+    int last = (latencyIndex + static_cast<int>(latencies.size()) - 1) % static_cast<int>(latencies.size());
+    ImGui::Text("Classifications: %ld", classifications);
+    ImGui::Text("Last: %.1f us  Mean: %.1f us", latencies[last], mean);
+    ImGui::Text("p50: %.1f us  p99: %.1f us  Max: %.1f us", sorted[count / 2],
+                sorted[std::min(count - 1, count * 99 / 100)], sorted.back());
+
+    //The plot starts at the oldest sample once the ring buffer has wrapped around
+    int offset = classifications > static_cast<long>(latencies.size()) ? latencyIndex : 0;
+    ImGui::PlotLines("Latency (us)", latencies.data(), count, offset, nullptr, 0.0f, sorted.back() * 1.1f,
+                     ImVec2(0, 60));
+}
+
+void DigitCanvas::draw() {
+    if (network == nullptr) {
+        return;
+    }
+
+    if (ImGui::Begin("Draw a digit")) {
+        if (side == 0) {
+            ImGui::TextUnformatted("The network inputs are not a square image");
+            ImGui::End();
+            return;
+        }
+
+        //The invisible button captures the mouse, so dragging on the canvas does not move the window
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        ImGui::InvisibleButton("canvas", ImVec2(static_cast<float>(canvasSide), static_cast<float>(canvasSide)));
+
+        bool changed = false;
+        if (ImGui::IsItemActive() && ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+            ImVec2 mouse = ImGui::GetIO().MousePos;
+            ImVec2 point(mouse.x - origin.x, mouse.y - origin.y);
+            if (drawing) {
+                paintLine(lastPoint, point);
+            } else {
+                paintDot(point);
+            }
+            changed = drawing == false || point.x != lastPoint.x || point.y != lastPoint.y;
+            lastPoint = point;
+            drawing = true;
+        } else {
+            drawing = false;
+        }
+
+        if (changed) {
+            classify();
+            dirty = true;
+        }
+        if (dirty) {
+            uploadTextures();
+        }
+
+        ImGui::GetWindowDrawList()->AddImage(toImTexture(canvasTexture), origin,
+                                             ImVec2(origin.x + canvasSide, origin.y + canvasSide));
+        ImGui::SameLine();
+
+        ImGui::BeginGroup();
+        ImGui::Image(toImTexture(inputsTexture), ImVec2(side * 3.0f, side * 3.0f));
+        if (ImGui::Button("Clear")) {
+            clear();
+        }
+        ImGui::SetNextItemWidth(side * 3.0f);
+        ImGui::SliderFloat("Brush", &brushRadius, 2.0f, 30.0f);
+        if (ImGui::Checkbox("Center", &centerDigit) && classifications > 0) {
+            classify();
+            dirty = true;
+        }
+        ImGui::EndGroup();
+
+        //The sigmoid outputs do not add up to 1, so they are normalized to be shown as probabilities
+        ImGui::SeparatorText(prediction >= 0 ? "Prediction" : "Draw on the canvas");
+        double total = 0;
+        for (auto &output: outputs) {
+            total += output;
+        }
+        for (int node = 0; node < outputs.size(); node++) {
+            float probability = total > 0 ? static_cast<float>(outputs[node] / total) : 0.0f;
+            char label[32];
+            snprintf(label, sizeof(label), "%d: %.1f%%", node, probability * 100.0f);
+            ImGui::ProgressBar(probability, ImVec2(-ImGui::GetFontSize() * 1.5f, 0), label);
+            if (node == prediction) {
+                ImGui::SameLine(0, 0);
+                ImGui::TextUnformatted(" <");
+            }
+        }
+
+        ImGui::SeparatorText("Inference latency");
+        drawLatencyStats();
+    }
+    ImGui::End();
+}
+
+void DigitCanvas::release() {
+    if (canvasTexture != 0) {
+        glDeleteTextures(1, &canvasTexture);
+        glDeleteTextures(1, &inputsTexture);
+        canvasTexture = 0;
+        inputsTexture = 0;
+    }
+    dirty = true;
+}
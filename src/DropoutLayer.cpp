@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "headers/DropoutLayer.h"
+
+using namespace neuralNet;
+
+// <-- DROPOUT LAYER IMPLEMENTATION --> //
+
+//Multiplies count values by their bit of the mask times the scale, the bits being read from the lowest one up
+void applyMask(const std::uint32_t *mask, const double *values, double *outputs, long count, double scale) {
+    for (long start = 0; start < count; start += 32) {
+        std::uint32_t word = mask[start / 32];
+        long end = std::min(count, start + 32);
+        for (long index = start; index < end; index++) {
+            outputs[index] = values[index] * (static_cast<double>((word >> (index - start)) & 1u) * scale);
+        }
+    }
+}
+
+DropoutLayer::DropoutLayer(double rate, ImageShape shape) {
+    if (!(rate >= 0 && rate < 1)) {
+        throw std::invalid_argument("The dropout rate must be in [0, 1)");
+    }
+    this->rate = rate;
+    this->shape = shape;
+
+    keepThreshold = static_cast<std::uint32_t>(std::lround((1 - rate) * (1u << randomBitsPerValue)));
+    keepThreshold = std::max(keepThreshold, 1u);
+    scale = static_cast<double>(1u << randomBitsPerValue) / keepThreshold;
+}
+
+const ImageShape &DropoutLayer::getOutputShape() const {
+    return shape;
+}
+
+double DropoutLayer::getRate() const {
+    return rate;
+}
+
+long DropoutLayer::parameterCount() const {
+    return 0;
+}
+
+void DropoutLayer::bindParameters(TensorView<double> parameters, TensorView<double> gradients) {}
+
+void DropoutLayer::initializeParameters(std::uint64_t seed) {
+    key = Philox::key(seed);
+    step = 0;
+}
+
+long DropoutLayer::wordsPerSample() const {
+    return (shape.size() + bitsPerWord - 1) / bitsPerWord;
+}
+
+std::size_t DropoutLayer::workspaceBytes(long batchSize) const {
+    //Activations, masks, then the gradients of the inputs
+    return Arena::bytesFor<double>(batchSize * shape.size())
+           + Arena::bytesFor<std::uint32_t>(batchSize * wordsPerSample())
+           + Arena::bytesFor<double>(batchSize * shape.size());
+}
+
+TensorView<const double> DropoutLayer::getActivations() const {
+    return activations;
+}
+
+void DropoutLayer::generateMasks(long batchSize) {
+    //A chunk of random numbers holds 16 bits for each value of two mask words, and takes 8 Philox counters
+    constexpr int wordsPerChunk = 2;
+    constexpr int randomsPerChunk = wordsPerChunk * bitsPerWord * randomBitsPerValue / 32;
+    constexpr std::uint32_t randomMask = (1u << randomBitsPerValue) - 1;
+    std::uint32_t randoms[randomsPerChunk];
+
+    long words = wordsPerSample();
+    for (long sample = 0; sample < batchSize; sample++) {
+        std::uint32_t *mask = masks.row(sample).data();
+        for (long firstWord = 0; firstWord < words; firstWord += wordsPerChunk) {
+            Philox::Counter counter = {static_cast<std::uint32_t>(firstWord / wordsPerChunk * randomsPerChunk / 4),
+                                       static_cast<std::uint32_t>(firstSample + sample),
+                                       static_cast<std::uint32_t>(step),
+                                       static_cast<std::uint32_t>(step >> 32)};
+            Philox::generateBlock(counter, key, randoms, randomsPerChunk);
+
+            //Every random number gives the bits of two values, its low half for the first one
+            for (long word = firstWord; word < std::min(words, firstWord + wordsPerChunk); word++) {
+                const std::uint32_t *wordRandoms = randoms + (word - firstWord) * bitsPerWord / 2;
+                std::uint32_t bits = 0;
+                for (int index = 0; index < bitsPerWord / 2; index++) {
+                    std::uint32_t random = wordRandoms[index];
+                    std::uint32_t lowKept = (random & randomMask) < keepThreshold;
+                    std::uint32_t highKept = (random >> randomBitsPerValue) < keepThreshold;
+                    bits |= lowKept << (2 * index) | highKept << (2 * index + 1);
+                }
+                mask[word] = bits;
+            }
+        }
+    }
+}
+
+void DropoutLayer::computeActivations(TensorView<const double> inputs, TensorView<double> outputs,
+                                      Arena &arena) const {
+    outputs.copyFrom(inputs);
+}
+
+void DropoutLayer::setPosition(std::uint64_t step, long firstSample) {
+    this->step = step;
+    this->firstSample = firstSample;
+}
+
+void DropoutLayer::calculateOutputs(TensorView<const double> inputs, Arena &arena) {
+    long batchSize = inputs.dim(0);
+    activations = arena.allocate<double>({batchSize, shape.size()});
+    masks = arena.allocate<std::uint32_t>({batchSize, wordsPerSample()});
+
+    generateMasks(batchSize);
+    step++;
+
+    for (long sample = 0; sample < batchSize; sample++) {
+        applyMask(masks.row(sample).data(), inputs.row(sample).data(), activations.row(sample).data(),
+                  shape.size(), scale);
+    }
+}
+
+TensorView<const double> DropoutLayer::backPropagate(TensorView<const double> outputGradients, Arena &arena,
+                                                     bool needInputGradients) {
+    if (!needInputGradients) {
+        return {};
+    }
+
+    //The outputs are the inputs times the same factor, so that is also the derivative
+    TensorView<double> inputGradients = arena.allocate<double>({outputGradients.dim(0), shape.size()});
+    for (long sample = 0; sample < outputGradients.dim(0); sample++) {
+        applyMask(masks.row(sample).data(), outputGradients.row(sample).data(), inputGradients.row(sample).data(),
+                  shape.size(), scale);
+    }
+    return inputGradients;
+}
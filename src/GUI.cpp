@@ -36,6 +36,11 @@ void GUIWindow::join() {
     }
 }
 
+void GUIWindow::attachNetwork(neuralNet::NeuralNetwork *network, const neuralNet::Dataset *dataset) {
+    visualizer.attach(network, dataset);
+    canvas.attach(network);
+}
+
 void GUIWindow::initialize() {
     if (!glfwInit()) {
         std::cout << "Could not initialize GUI window. glfwInit() Failed" << std::endl;
@@ -70,26 +75,22 @@ void GUIWindow::render() {
     ImGui::NewFrame();
 
     //Add ImGui UI elements and logic
-
-    //Example: Create a window with a button that changes the window's background color
-    if (ImGui::Begin("My Window")) {
-        if (ImGui::Button("Change Color")) {
-            // Change the window's background color
-            glClearColor(1.0f, 1.0f, 0.0f, 1.0f);
-        }
-    }
-    ImGui::End();
+    visualizer.draw();
+    canvas.draw();
 
     //Render ImGui UI
     ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-    //Restore the default OpenGL clear color
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
 void GUIWindow::shutdown() {
     join();
+
+    //The textures have to be deleted before the OpenGL context is destroyed
+    visualizer.release();
+    canvas.release();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
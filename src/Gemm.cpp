@@ -0,0 +1,80 @@
+#include "headers/Gemm.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace neuralNet;
+
+// <-- HELPER FUNCTIONS --> //
+
+//Copies the block [firstRow, firstRow + rows) x [firstColumn, firstColumn + columns) of a matrix into a packed buffer
+void packBlock(TensorView<const double> matrix, long firstRow, long rows, long firstColumn, long columns,
+               double *packed) {
+    for (long row = 0; row < rows; row++) {
+        const double *source = &matrix(firstRow + row, firstColumn);
+        double *target = packed + row * columns;
+
+        //Rows of a non transposed matrix are contiguous, those of a transposed one have to be gathered
+        if (matrix.stride(1) == 1) {
+            std::copy(source, source + columns, target);
+        } else {
+            for (long column = 0; column < columns; column++) {
+                target[column] = source[column * matrix.stride(1)];
+            }
+        }
+    }
+}
+
+// <-- GEMM IMPLEMENTATION --> //
+
+void neuralNet::gemm(TensorView<const double> a, TensorView<const double> b, TensorView<double> c, bool accumulate) {
+    long m = a.dim(0);
+    long k = a.dim(1);
+    long n = b.dim(1);
+    assert(b.dim(0) == k && c.dim(0) == m && c.dim(1) == n);
+
+    if (!accumulate) {
+        c.fill(0);
+    }
+
+    //Every thread gets its own packing buffers, allocated the first time it multiplies matrices
+    thread_local Tensor<double> packedA({gemmBlockRows, gemmBlockDepth});
+    thread_local Tensor<double> packedB({gemmBlockDepth, gemmBlockColumns});
+
+    for (long firstColumn = 0; firstColumn < n; firstColumn += gemmBlockColumns) {
+        long columns = std::min(gemmBlockColumns, n - firstColumn);
+
+        for (long firstDepth = 0; firstDepth < k; firstDepth += gemmBlockDepth) {
+            long depth = std::min(gemmBlockDepth, k - firstDepth);
+            packBlock(b, firstDepth, depth, firstColumn, columns, packedB.data());
+
+            for (long firstRow = 0; firstRow < m; firstRow += gemmBlockRows) {
+                long rows = std::min(gemmBlockRows, m - firstRow);
+                packBlock(a, firstRow, rows, firstDepth, depth, packedA.data());
+
+                //c[row, :] += a[row, p] * b[p, :], the inner loop runs along contiguous rows of b and c
+                for (long row = 0; row < rows; row++) {
+                    const double *aRow = packedA.data() + row * depth;
+                    double *cRow = &c(firstRow + row, firstColumn);
+                    long cStride = c.stride(1);
+
+                    for (long p = 0; p < depth; p++) {
+                        double aValue = aRow[p];
+                        if (aValue == 0) {
+                            continue;
+                        }
+                        const double *bRow = packedB.data() + p * columns;
+                        if (cStride == 1) {
+                            for (long column = 0; column < columns; column++) {
+                                cRow[column] += aValue * bRow[column];
+                            }
+                        } else {
+                            for (long column = 0; column < columns; column++) {
+                                cRow[column * cStride] += aValue * bRow[column];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "headers/IdxReader.h"
+
+using namespace neuralNet;
+
+// <-- HELPER FUNCTIONS --> //
+
+std::uint32_t readBigEndian(const std::uint8_t *bytes) {
+    return static_cast<std::uint32_t>(bytes[0]) << 24 | static_cast<std::uint32_t>(bytes[1]) << 16
+           | static_cast<std::uint32_t>(bytes[2]) << 8 | static_cast<std::uint32_t>(bytes[3]);
+}
+
+// <-- IDX FILE IMPLEMENTATION --> //
+
+IdxFile::IdxFile(const std::string &path) : file(path) {
+    const std::uint8_t *bytes = file.data();
+    if (file.size() < 4 || bytes[0] != 0 || bytes[1] != 0) {
+        throw std::runtime_error(path + " is not an IDX file");
+    }
+    if (bytes[2] != unsignedByteType) {
+        throw std::runtime_error(path + " holds values of type " + std::to_string(bytes[2])
+                                 + ", only unsigned bytes are supported");
+    }
+
+    int dimensionCount = bytes[3];
+    std::size_t headerBytes = 4 + 4 * static_cast<std::size_t>(dimensionCount);
+    if (dimensionCount == 0 || file.size() < headerBytes) {
+        throw std::runtime_error(path + " has a cut short header");
+    }
+
+    //Checked against the size of the file as it goes, so a corrupt dimension can not overflow the product
+    std::size_t valueCount = 1;
+    for (int dimension = 0; dimension < dimensionCount; dimension++) {
+        dims.push_back(readBigEndian(bytes + 4 + 4 * dimension));
+        valueCount *= dims.back();
+        if (valueCount > file.size()) {
+            break;
+        }
+    }
+    if (headerBytes + valueCount != file.size()) {
+        throw std::runtime_error(path + " is " + std::to_string(file.size()) + " bytes, its header describes "
+                                 + std::to_string(headerBytes + valueCount));
+    }
+}
+
+const std::vector<long> &IdxFile::dimensions() const {
+    return dims;
+}
+
+long IdxFile::count() const {
+    return dims[0];
+}
+
+long IdxFile::itemSize() const {
+    long size = 1;
+    for (std::size_t dimension = 1; dimension < dims.size(); dimension++) {
+        size *= dims[dimension];
+    }
+    return size;
+}
+
+const std::uint8_t *IdxFile::values() const {
+    return file.data() + 4 + 4 * dims.size();
+}
+
+// <-- IDX DATASET IMPLEMENTATION --> //
+
+Dataset neuralNet::readIdx(const std::string &imagesPath, const std::string &labelsPath, int numClasses) {
+    auto images = std::make_shared<IdxFile>(imagesPath);
+    IdxFile labelFile(labelsPath);
+    if (labelFile.dimensions().size() != 1 || labelFile.count() != images->count()) {
+        throw std::runtime_error(labelsPath + " does not hold a label for each of the " +
+                                 std::to_string(images->count()) + " images of " + imagesPath);
+    }
+
+    //The labels are widened to the dataset's integers, which is a byte per sample next to a whole image
+    std::vector<int> labels(labelFile.values(), labelFile.values() + labelFile.count());
+    for (int label: labels) {
+        if (label >= numClasses) {
+            throw std::runtime_error(labelsPath + " has the label " + std::to_string(label) + " for "
+                                     + std::to_string(numClasses) + " classes");
+        }
+    }
+
+    const std::uint8_t *inputs = images->values();
+    int inputSize = static_cast<int>(images->itemSize());
+    return Dataset::view(inputSize, numClasses, inputs, std::move(labels), std::move(images));
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cmath>
+#include "headers/Initialization.h"
+#include "headers/Random.h"
+#include "headers/ThreadPool.h"
+#include "headers/Gemm.h"
+
+using namespace neuralNet;
+
+// <-- INITIALIZATION IMPLEMENTATION --> //
+
+//Rows orthonormalized together before the rest of the matrix is updated, and rows of the rest per task
+constexpr long orthogonalPanelRows = 32;
+constexpr long orthogonalUpdateRows = 64;
+
+//Fills a contiguous view with N(0, deviation), chunks of it being generated in parallel
+void fillNormalParallel(TensorView<double> values, double deviation, Philox::Key key, std::uint32_t stream) {
+    double *data = values.data();
+    ThreadPool::global().parallelFor(0, values.size(), initializationChunkSize, [&](long begin, long end) {
+        fillNormal(data + begin, begin, end - begin, deviation, key, stream);
+    });
+}
+
+//Orthonormalizes the rows of a matrix that has no more rows than columns
+void orthonormalizeRows(TensorView<double> matrix) {
+    long rows = matrix.dim(0);
+    long columns = matrix.dim(1);
+
+    for (long panelStart = 0; panelStart < rows; panelStart += orthogonalPanelRows) {
+        long panelEnd = std::min(rows, panelStart + orthogonalPanelRows);
+
+        //The rows of the panel are already orthogonal to the earlier panels, so only the panel itself is left
+        for (long row = panelStart; row < panelEnd; row++) {
+            double *values = matrix.row(row).data();
+            for (long previous = panelStart; previous < row; previous++) {
+                const double *previousValues = matrix.row(previous).data();
+                double dot = 0;
+                for (long column = 0; column < columns; column++) {
+                    dot += values[column] * previousValues[column];
+                }
+                for (long column = 0; column < columns; column++) {
+                    values[column] -= dot * previousValues[column];
+                }
+            }
+
+            double norm = 0;
+            for (long column = 0; column < columns; column++) {
+                norm += values[column] * values[column];
+            }
+            norm = std::sqrt(norm);
+            for (long column = 0; column < columns; column++) {
+                values[column] = norm > 0 ? values[column] / norm : 0;
+            }
+        }
+
+        //Remove the directions of the panel from every row after it: rest -= (rest * panel^T) * panel
+        TensorView<double> panel = matrix.slice(panelStart, panelEnd);
+        ThreadPool::global().parallelFor(panelEnd, rows, orthogonalUpdateRows, [&](long begin, long end) {
+            TensorView<double> rest = matrix.slice(begin, end);
+            Tensor<double> projections({end - begin, panelEnd - panelStart});
+            gemm(rest, panel.transpose(), projections);
+            for (auto &projection: projections) {
+                projection = -projection;
+            }
+            gemm(projections, panel, rest, true);
+        });
+    }
+}
+
+void neuralNet::orthonormalize(TensorView<double> matrix) {
+    if (matrix.dim(0) <= matrix.dim(1)) {
+        orthonormalizeRows(matrix);
+        return;
+    }
+
+    //The columns are the shorter side, so they are made the rows of a copy
+    Tensor<double> transposed(matrix.transpose());
+    orthonormalizeRows(transposed);
+    matrix.copyFrom(transposed.view().transpose());
+}
+
+void neuralNet::initializeWeights(InitScheme scheme, TensorView<double> weights, TensorView<double> biases,
+                                  long fanIn, long fanOut, std::uint64_t seed) {
+    Philox::Key key = Philox::key(seed);
+
+    switch (scheme) {
+        case InitScheme::Default:
+        case InitScheme::Gaussian:
+            fillNormalParallel(weights, 1.0, key, weightInitStream);
+            fillNormalParallel(biases, 1.0, key, biasInitStream);
+            break;
+        case InitScheme::LeCun:
+            fillNormalParallel(weights, 1.0 / std::sqrt(static_cast<double>(fanIn)), key, weightInitStream);
+            fillNormalParallel(biases, 1.0 / std::sqrt(static_cast<double>(fanIn)), key, biasInitStream);
+            break;
+        case InitScheme::Xavier:
+            fillNormalParallel(weights, std::sqrt(2.0 / static_cast<double>(fanIn + fanOut)), key, weightInitStream);
+            biases.fill(0);
+            break;
+        case InitScheme::He:
+            fillNormalParallel(weights, std::sqrt(2.0 / static_cast<double>(fanIn)), key, weightInitStream);
+            biases.fill(0);
+            break;
+        case InitScheme::Orthogonal:
+            fillNormalParallel(weights, 1.0, key, weightInitStream);
+            orthonormalize(weights);
+            biases.fill(0);
+            break;
+    }
+}
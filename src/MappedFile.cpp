@@ -0,0 +1,127 @@
+#include <stdexcept>
+#include <utility>
+#include "headers/MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace neuralNet;
+
+// <-- MAPPED FILE IMPLEMENTATION --> //
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+        : address(std::exchange(other.address, nullptr)), bytes(std::exchange(other.bytes, 0)),
+          mapping(std::exchange(other.mapping, nullptr)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        release();
+        address = std::exchange(other.address, nullptr);
+        bytes = std::exchange(other.bytes, 0);
+        mapping = std::exchange(other.mapping, nullptr);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+const std::uint8_t *MappedFile::data() const {
+    return address;
+}
+
+std::size_t MappedFile::size() const {
+    return bytes;
+}
+
+#ifdef _WIN32
+
+void MappedFile::release() {
+    if (address != nullptr) {
+        UnmapViewOfFile(address);
+        address = nullptr;
+    }
+    if (mapping != nullptr) {
+        CloseHandle(static_cast<HANDLE>(mapping));
+        mapping = nullptr;
+    }
+    bytes = 0;
+}
+
+MappedFile::MappedFile(const std::string &path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Could not open " + path);
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        throw std::runtime_error("Could not read the size of " + path);
+    }
+    if (fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return;
+    }
+
+    //The mapping keeps the file open, so its handle is not needed any more
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        throw std::runtime_error("Could not map " + path);
+    }
+    address = static_cast<const std::uint8_t *>(MapViewOfFile(static_cast<HANDLE>(mapping), FILE_MAP_READ, 0, 0, 0));
+    if (address == nullptr) {
+        release();
+        throw std::runtime_error("Could not map " + path);
+    }
+    bytes = static_cast<std::size_t>(fileSize.QuadPart);
+}
+
+#else
+
+void MappedFile::release() {
+    if (address != nullptr) {
+        munmap(const_cast<std::uint8_t *>(address), bytes);
+        address = nullptr;
+    }
+    bytes = 0;
+}
+
+MappedFile::MappedFile(const std::string &path) {
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("Could not open " + path + ": " + std::strerror(errno));
+    }
+    struct stat status{};
+    if (fstat(descriptor, &status) != 0) {
+        ::close(descriptor);
+        throw std::runtime_error("Could not read the size of " + path + ": " + std::strerror(errno));
+    }
+    if (status.st_size == 0) {
+        ::close(descriptor);
+        return;
+    }
+
+    //The mapping keeps the file open, so the descriptor is not needed any more
+    void *mapped = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("Could not map " + path + ": " + std::strerror(errno));
+    }
+    madvise(mapped, static_cast<std::size_t>(status.st_size), MADV_WILLNEED);
+    address = static_cast<const std::uint8_t *>(mapped);
+    bytes = static_cast<std::size_t>(status.st_size);
+}
+
+#endif
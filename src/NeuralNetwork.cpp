@@ -2,18 +2,24 @@
 // Created by 1flor on 28/05/2023.
 //
 
+#include <algorithm>
 #include <limits>
-#include <cmath>
 #include "headers/NeuralNetwork.h"
+#include "headers/Activation.h"
 #include <iostream>
-#include <random>
-#include <utility>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 
 using namespace neuralNet;
 
+//Values of the parameter and gradient buffers per task when they are updated in parallel
+constexpr long parallelChunkSize = 64 * 1024;
+
 // <-- HELPER FUNCTIONS --> //
 
-int findCorrectActivationIndex(const std::vector<double>& vec) {
+int findCorrectActivationIndex(TensorView<const double> vec) {
     for (int i = 0; i < vec.size(); i++) {
         if (vec[i] == 1) {
             return i;
@@ -22,289 +28,1039 @@ int findCorrectActivationIndex(const std::vector<double>& vec) {
     return -1;
 }
 
-// <-- LAYER IMPLEMENTATION --> //
+int findMaxActivationIndex(TensorView<const double> activations) {
+    double maxValue = std::numeric_limits<double>::lowest();
+    int maxNode = 0;
 
-Layer::Layer(int numNodesIn, int numNodesOut) {
-    this->numNodesIn = numNodesIn;
-    this->numNodesOut = numNodesOut;
+    //Go through the output nodes and find the one with the highest activation value
+    for (int node = 0; node < activations.size(); node++) {
+        if (activations[node] > maxValue) {
+            maxValue = activations[node];
+            maxNode = node;
+        }
+    }
+    return maxNode;
+}
 
-    //Initialize activations and set all the values to 0
-    activations.resize(numNodesOut, 0);
+//Counts the samples whose highest output is their label, the outputs starting at sample firstSample of the batch
+int countCorrectAnswers(TensorView<const double> outputs, const std::vector<int> &labels, long firstSample) {
+    int correctAnswers = 0;
+    for (long sample = 0; sample < outputs.dim(0); sample++) {
+        int choice = findMaxActivationIndex(outputs.row(sample));
+        //std::cout << choice << " ? " << labels[firstSample + sample] << " | ";
+        if (choice == labels[firstSample + sample]) {
+            correctAnswers += 1;
+        }
+    }
+    return correctAnswers;
+}
+
+//Returns the derivatives of the cost with respect to the outputs, allocated from the arena
+TensorView<const double> outputCostGradients(TensorView<const double> outputs,
+                                             TensorView<const double> expectedOutputs, Arena &arena) {
+    TensorView<double> outputGradients = arena.allocate<double>({outputs.dim(0), outputs.dim(1)});
+    for (long sample = 0; sample < outputs.dim(0); sample++) {
+        for (long node = 0; node < outputs.dim(1); node++) {
+            outputGradients(sample, node) = squaredErrorDerivative(outputs(sample, node), expectedOutputs(sample, node));
+        }
+    }
+    return outputGradients;
+}
 
-    inputs.resize(numNodesIn);
+//Rough number of multiply-adds a layer does per sample, to give the stages of a pipeline the same amount of work
+double estimateLayerWork(const NetworkLayer &layer) {
+    return std::visit([](auto &layer) {
+        using LayerType = std::decay_t<decltype(layer)>;
+        const ImageShape &shape = layer.getOutputShape();
+        if constexpr (std::is_same_v<LayerType, Conv2DLayer>) {
+            //Every weight is used once per output pixel
+            return static_cast<double>(layer.parameterCount()) * shape.height * shape.width;
+        } else {
+            return static_cast<double>(layer.parameterCount() + shape.size());
+        }
+    }, layer);
+}
 
-    //Initialize all the weights between the previous layer and this one
-    weights.resize(numNodesIn, std::vector<double>(numNodesOut));
-    costGradientW.resize(numNodesIn, std::vector<double>(numNodesOut));
+//Packs data points into a batch, so they can go through the batched code path
+Batch toBatch(const std::vector<DataPoint> &dataPoints) {
+    Batch batch;
+    long inputSize = dataPoints[0].getInputData().size();
+    long outputSize = dataPoints[0].getExpectedOutputs().size();
+    batch.inputs = Tensor<double>({static_cast<long>(dataPoints.size()), inputSize});
+    batch.expectedOutputs = Tensor<double>({static_cast<long>(dataPoints.size()), outputSize});
+
+    for (int index = 0; index < dataPoints.size(); index++) {
+        batch.inputs.row(index).copyFrom(dataPoints[index].getInputData());
+        batch.expectedOutputs.row(index).copyFrom(dataPoints[index].getExpectedOutputs());
+        batch.labels.push_back(findCorrectActivationIndex(dataPoints[index].getExpectedOutputs()));
+    }
+    return batch;
+}
 
-    //Initialize a bias for each node
-    biases.resize(numNodesOut);
-    costGradientB.resize(numNodesOut);
+// <-- LAYER INFO IMPLEMENTATION --> //
 
-    randomizeWeightsAndBiases();
+LayerInfo LayerInfo::input(int size) {
+    return input(1, 1, size);
 }
 
-void Layer::randomizeWeightsAndBiases() {
-    //Generate random numbers based on the Gaussian distribution
-    std::random_device random;
-    std::mt19937 gen(random());
-    std::normal_distribution<double> distribution(0.0, 1.0);
+LayerInfo LayerInfo::input(int channels, int height, int width) {
+    LayerInfo info;
+    info.type = Type::Input;
+    info.shape = {channels, height, width};
+    info.size = static_cast<int>(info.shape.size());
+    return info;
+}
 
-    for (int nodeIn = 0; nodeIn < numNodesIn; nodeIn++) {
-        for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
-            weights[nodeIn][nodeOut] = distribution(gen);
-        }
+LayerInfo LayerInfo::dense(int nodes, ActivationFunction activation, InitScheme initialization) {
+    LayerInfo info;
+    info.type = Type::Dense;
+    info.size = nodes;
+    info.activation = activation;
+    info.initialization = initialization;
+    return info;
+}
+
+LayerInfo LayerInfo::conv2D(int channels, int kernelSize, int stride, int padding, ActivationFunction activation,
+                            InitScheme initialization) {
+    LayerInfo info;
+    info.type = Type::Conv2D;
+    info.size = channels;
+    info.kernelSize = kernelSize;
+    info.stride = stride;
+    info.padding = padding;
+    info.activation = activation;
+    info.initialization = initialization;
+    return info;
+}
+
+LayerInfo LayerInfo::maxPool(int poolSize, int stride) {
+    LayerInfo info;
+    info.type = Type::MaxPool;
+    info.kernelSize = poolSize;
+    info.stride = stride == 0 ? poolSize : stride;
+    return info;
+}
+
+LayerInfo LayerInfo::avgPool(int poolSize, int stride) {
+    LayerInfo info = maxPool(poolSize, stride);
+    info.type = Type::AvgPool;
+    return info;
+}
+
+LayerInfo LayerInfo::flatten() {
+    LayerInfo info;
+    info.type = Type::Flatten;
+    return info;
+}
+
+LayerInfo LayerInfo::activationLayer(ActivationFunction activation) {
+    LayerInfo info;
+    info.type = Type::Activation;
+    info.activation = activation;
+    return info;
+}
+
+LayerInfo LayerInfo::dropout(double rate) {
+    LayerInfo info;
+    info.type = Type::Dropout;
+    info.rate = rate;
+    return info;
+}
+
+LayerInfo LayerInfo::batchNorm() {
+    LayerInfo info;
+    info.type = Type::BatchNorm;
+    return info;
+}
+
+// <-- NEURAL NETWORK IMPLEMENTATION --> //
+
+//Describes a network of dense sigmoid layers, from the number of nodes of each layer
+std::vector<LayerInfo> denseLayersInfo(const std::vector<int> &layerSizes) {
+    std::vector<LayerInfo> layersInfo = {LayerInfo::input(layerSizes[0])};
+    for (int index = 1; index < layerSizes.size(); index++) {
+        layersInfo.push_back(LayerInfo::dense(layerSizes[index]));
     }
+    return layersInfo;
+}
 
-    for (int node = 0; node < numNodesOut; node++) {
-        biases[node] = distribution(gen);
+//Builds the layer an entry describes, for inputs of the given shape
+NetworkLayer createLayer(const LayerInfo &info, ImageShape shape) {
+    switch (info.type) {
+        case LayerInfo::Type::Dense:
+            return DenseLayer(static_cast<int>(shape.size()), info.size, info.activation, info.initialization);
+        case LayerInfo::Type::Conv2D:
+            return Conv2DLayer(shape, info.size, info.kernelSize, info.stride, info.padding, info.activation,
+                               info.initialization);
+        case LayerInfo::Type::MaxPool:
+            return PoolLayer(PoolingType::Max, shape, info.kernelSize, info.stride);
+        case LayerInfo::Type::AvgPool:
+            return PoolLayer(PoolingType::Average, shape, info.kernelSize, info.stride);
+        case LayerInfo::Type::Flatten:
+            return FlattenLayer(shape);
+        case LayerInfo::Type::Activation:
+            return ActivationLayer(info.activation, shape);
+        case LayerInfo::Type::Dropout:
+            return DropoutLayer(info.rate, shape);
+        case LayerInfo::Type::BatchNorm:
+            return BatchNormLayer(shape);
+        default:
+            throw std::invalid_argument("Only the first layer of a network can be an input");
     }
 }
 
-void Layer::calculateOutputs(std::vector<double> inputs) {
-    this->inputs = inputs;
+NeuralNetwork::NeuralNetwork(const std::vector<int> &layersInfo, int maxBatchSize, std::uint64_t seed)
+        : NeuralNetwork(denseLayersInfo(layersInfo), maxBatchSize, seed) {}
 
-    //For each node in this layer
-    for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
-        //Add the bias of this node
-        double weightedInput = biases[nodeOut];
+NeuralNetwork::NeuralNetwork(const std::vector<LayerInfo> &layersInfo, int maxBatchSize, std::uint64_t seed)
+        : scratch(0), masterSeed(seed), maxBatchSize(maxBatchSize) {
+    if (layersInfo.size() < 2 || layersInfo[0].type != LayerInfo::Type::Input) {
+        throw std::invalid_argument("A network needs an input followed by at least one layer");
+    }
+    numInputs = layersInfo[0].shape.size();
+
+    //Follow the shape of the values from each layer to the next one
+    ImageShape shape = layersInfo[0].shape;
+    for (int index = 1; index < layersInfo.size(); index++) {
+        layers.push_back(createLayer(layersInfo[index], shape));
+        shape = std::visit([](auto &layer) { return ImageShape(layer.getOutputShape()); }, layers.back());
 
-        /* For each node in the previous layer, multiply its activation value by the weight
-           of the connection between this node and the one from the previous layer.
-           Formula ends up being: b + a1 * w1 + a2 * w2 + ... */
-        for (int nodeIn = 0; nodeIn < numNodesIn; nodeIn++) {
-            weightedInput += inputs[nodeIn] * weights[nodeIn][nodeOut];
+        if (shape.height <= 0 || shape.width <= 0) {
+            throw std::invalid_argument("Layer " + std::to_string(index) + " leaves no pixels in the image");
         }
+    }
 
-        //Apply the activation function and add the activation value of this node
-        activations[nodeOut] = activationSigmoid(weightedInput);
+    /* Give every layer its slice of the parameter and gradient buffers. The slices start on a cache line,
+       so the rows of every layer stay as aligned as they were when each layer had its own tensors */
+    long alignment = tensorAlignment / sizeof(double);
+    long totalParameters = 0;
+    for (auto &layer: layers) {
+        parameterOffsets.push_back(totalParameters);
+        long count = std::visit([](auto &layer) { return layer.parameterCount(); }, layer);
+        totalParameters += (count + alignment - 1) / alignment * alignment;
+    }
+    parameterStorage = Tensor<double>({totalParameters});
+    gradientStorage = Tensor<double>({totalParameters});
+    parameters = parameterStorage;
+    gradients = gradientStorage;
+
+    bindLayers(layers, gradients);
+    for (int index = 0; index < layers.size(); index++) {
+        std::visit([&](auto &layer) { layer.initializeParameters(mixSeed(masterSeed, index)); }, layers[index]);
     }
+
+    scratch = Arena(workspaceBytes(maxBatchSize));
+    sampleWorkspaceBytes = workspaceBytes(1);
 }
 
-double Layer::activationSigmoid(const double input) {
-    return 1.0 / (1.0 + exp(-input));
+void NeuralNetwork::bindLayers(std::vector<NetworkLayer> &layers, TensorView<double> layerGradients, int firstLayer) {
+    for (int index = 0; index < layers.size(); index++) {
+        std::visit([&](auto &layer) {
+            long count = layer.parameterCount();
+            long offset = parameterOffsets[firstLayer + index];
+            layer.bindParameters(parameters.slice(offset, offset + count),
+                                 layerGradients.slice(offset, offset + count));
+        }, layers[index]);
+    }
 }
 
-double Layer::activationSigmoidDerivative(double input) {
-    double activation = activationSigmoid(input);
-    return activation * (1 - activation);
+std::size_t NeuralNetwork::workspaceBytes(long batchSize) const {
+    //Add up the scratch memory every layer needs for a step, along with the derivatives of the cost at the outputs
+    long outputSize = std::visit([](auto &layer) { return layer.getOutputShape().size(); }, layers.back());
+    std::size_t bytes = Arena::bytesFor<double>(batchSize * outputSize);
+    for (auto &layer: layers) {
+        bytes += std::visit([&](auto &layer) { return layer.workspaceBytes(batchSize); }, layer);
+    }
+    return bytes;
 }
 
-double Layer::calculateCost(double outputActivation, double expectedOutput) {
-    double error = outputActivation - expectedOutput;
-    return error * error;
+TensorView<const double> NeuralNetwork::calculateOutputs(std::vector<NetworkLayer> &layers,
+                                                         TensorView<const double> inputs, Arena &arena) {
+    //Calculate the output of each layer and feed it as an input to the next layer
+    TensorView<const double> layerInputs = inputs;
+    for (auto &layer: layers) {
+        layerInputs = std::visit([&](auto &layer) {
+            layer.calculateOutputs(layerInputs, arena);
+            return layer.getActivations();
+        }, layer);
+    }
+    return layerInputs;
 }
 
-double Layer::calculateCostDerivative(double outputActivation, double expectedOutput) {
-    return 2 * (outputActivation - expectedOutput);
+std::vector<TensorView<const double>> NeuralNetwork::computeLayerOutputs(TensorView<const double> inputs,
+                                                                          Arena &arena) const {
+    std::vector<TensorView<const double>> outputs;
+    TensorView<const double> layerInputs = inputs;
+
+    for (auto &layer: layers) {
+        layerInputs = std::visit([&](auto &layer) {
+            //Dropout does nothing outside of training, and neither does a folded normalization
+            using LayerType = std::decay_t<decltype(layer)>;
+            if constexpr (std::is_same_v<LayerType, DropoutLayer>) {
+                return layerInputs;
+            } else if constexpr (std::is_same_v<LayerType, BatchNormLayer>) {
+                if (layer.isFolded()) {
+                    return layerInputs;
+                }
+            }
+            TensorView<double> layerOutputs = arena.allocate<double>({inputs.dim(0), layer.getOutputShape().size()});
+            layer.computeActivations(layerInputs, layerOutputs, arena);
+            return TensorView<const double>(layerOutputs);
+        }, layer);
+        outputs.push_back(layerInputs);
+    }
+    return outputs;
 }
 
-int Layer::length() const {
-    return numNodesOut;
+Tensor<double> NeuralNetwork::predict(TensorView<const double> inputs) const {
+    std::shared_lock<std::shared_mutex> lock(parametersMutex);
+
+    //The layers work on batches, so the inputs are seen as a batch with a single sample
+    Arena arena(sampleWorkspaceBytes);
+    std::vector<TensorView<const double>> outputs = computeLayerOutputs(inputs.reshape({1, inputs.size()}), arena);
+    return Tensor<double>(outputs.back().row(0));
 }
 
-int Layer::nodesIn() const {
-    return numNodesIn;
+int NeuralNetwork::classify(TensorView<const double> inputs) const {
+    return findMaxActivationIndex(predict(inputs));
 }
 
-std::vector<double> Layer::getActivations() {
-    return activations;
+double NeuralNetwork::calculateCost(TensorView<const double> inputs, TensorView<const double> expectedOutputs,
+                                    Arena &arena) const {
+    TensorView<const double> outputs = computeLayerOutputs(inputs, arena).back();
+    double cost = 0;
+
+    //Add up the cost from each of the outputs, for every sample in the batch
+    for (long sample = 0; sample < outputs.dim(0); sample++) {
+        for (long nodeOut = 0; nodeOut < outputs.dim(1); nodeOut++) {
+            cost += squaredError(outputs(sample, nodeOut), expectedOutputs(sample, nodeOut));
+        }
+    }
+    return cost;
 }
 
-void Layer::adjustWeight(int nodeIn, int nodeOut, double value) {
-    weights[nodeIn][nodeOut] += value;
+double NeuralNetwork::cost(const Batch &batch) {
+    if (trainingMode == TrainingMode::Serial || trainingMode == TrainingMode::Pipeline) {
+        scratch.reset();
+
+        //Return the average cost between the data points
+        return calculateCost(batch.inputs, batch.expectedOutputs, scratch) / batch.size();
+    }
+
+    //Every shard adds up its own cost, and the shards are added up in order, so the result never depends on timing
+    long shards = static_cast<long>(contexts.size());
+    std::vector<double> shardCosts(shards, 0.0);
+    pool->run(shards, [&](long shard) {
+        long begin = batch.size() * shard / shards;
+        long end = batch.size() * (shard + 1) / shards;
+        if (begin == end) {
+            return;
+        }
+        TrainingContext &context = contexts[shard];
+        context.scratch.reset();
+        shardCosts[shard] = calculateCost(batch.inputs.view().slice(begin, end),
+                                          batch.expectedOutputs.view().slice(begin, end), context.scratch);
+    });
+
+    double totalCost = 0;
+    for (double shardCost: shardCosts) {
+        totalCost += shardCost;
+    }
+    return totalCost / batch.size();
 }
 
-void Layer::adjustBias(int node, double value) {
-    biases[node] += value;
+double NeuralNetwork::cost(const std::vector<DataPoint> &dataPoints) {
+    return cost(toBatch(dataPoints));
 }
 
-void Layer::setCostGradientW(int nodeIn, int nodeOut, double value) {
-    costGradientW[nodeIn][nodeOut] = value;
+void NeuralNetwork::gradientDescent(const Batch &batch) {
+    double learnRate = 1;
+    int correctAnswers;
+
+    if (trainingMode == TrainingMode::Serial && ring == nullptr && shared == nullptr) {
+        //Everything the back propagation allocated for the previous mini-batch can be reused
+        scratch.reset();
+        TensorView<const double> outputs = backPropagation(layers, scratch, batch.inputs, batch.expectedOutputs);
+
+        //The back propagation already ran the inputs through the network, so the choices can be read from the outputs
+        correctAnswers = countCorrectAnswers(outputs, batch.labels, 0);
+    } else if (trainingMode == TrainingMode::Serial) {
+        //Every process must drop other values than the others, so the masks follow the samples
+        for (auto &layer: layers) {
+            if (auto *dropout = std::get_if<DropoutLayer>(&layer)) {
+                dropout->setPosition(trainingStep, firstProcessSample(batch));
+            }
+        }
+        trainingStep++;
+
+        /* A bucket goes around the ring once the back propagation reached its first layer, the layers before it
+           overlap. There are no buckets without a ring */
+        std::size_t nextBucket = 0;
+        auto layerDone = [&](int index) {
+            if (nextBucket < gradientBuckets.size() && gradientBuckets[nextBucket].firstLayer == index) {
+                GradientBucket &bucket = gradientBuckets[nextBucket++];
+                ring->startAllReduce(gradients.data() + bucket.begin, bucket.end - bucket.begin);
+            }
+        };
+
+        scratch.reset();
+        TensorView<const double> outputs = backPropagation(layers, scratch, batch.inputs, batch.expectedOutputs,
+                                                           layerDone);
+        correctAnswers = countCorrectAnswers(outputs, batch.labels, 0);
+        if (ring != nullptr) {
+            ring->wait();
+        }
+    } else {
+        correctAnswers = trainingMode == TrainingMode::Pipeline ? pipelinedBackPropagation(batch)
+                                                                : shardedBackPropagation(batch);
+
+        //The shards are only added up at the end, so there is nothing to overlap with
+        if (ring != nullptr) {
+            ring->allReduce(gradients.data(), gradients.size());
+        }
+    }
+
+    //Every process trains on a batch of the same size, and the gradients are the sum over all of them
+    int processes = ring != nullptr ? ring->size() : shared != nullptr ? shared->workerCount() : 1;
+    long totalSamples = static_cast<long>(batch.size()) * processes;
+    std::cout << "Accuracy: " << correctAnswers << " / " << batch.size() << ", ";
+    applyAllGradients(learnRate / totalSamples);
 }
 
-void Layer::setCostGradientB(int node, double value) {
-    costGradientB[node] = value;
+void NeuralNetwork::gradientDescent(const std::vector<DataPoint> &dataPoints) {
+    gradientDescent(toBatch(dataPoints));
 }
 
-void Layer::printNodes() {
-    for (int nodeIn = 0; nodeIn < numNodesIn; nodeIn++) {
-        for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
-            std::cout << "Node in: " << nodeIn << ", Node out: " << nodeOut << ", Value: " << weights[nodeIn][nodeOut]
-                      << std::endl;
+void NeuralNetwork::applyAllGradients(double learnRate) {
+    std::unique_lock<std::shared_mutex> lock(parametersMutex);
+    parametersVersion++;
+
+    //With shared memory, the gradients of every worker are applied together
+    if (shared != nullptr) {
+        shared->reduce(learnRate);
+        return;
+    }
+
+    //Every weight and bias of the network is in the same buffer, with its gradient at the same index
+    double *parameterValues = parameters.data();
+    double *gradientValues = gradients.data();
+    auto applyRange = [&](long begin, long end) {
+        for (long index = begin; index < end; index++) {
+            parameterValues[index] -= gradientValues[index] * learnRate;
+            gradientValues[index] = 0;
         }
+    };
+
+    //Every value is updated on its own, so splitting the buffer over threads changes nothing to the result
+    if (trainingMode == TrainingMode::Serial) {
+        applyRange(0, parameters.size());
+    } else {
+        pool->parallelFor(0, parameters.size(), parallelChunkSize, applyRange);
     }
 }
 
-void Layer::applyGradients(double learnRate) {
-    for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
-        biases[nodeOut] -= costGradientB[nodeOut] * learnRate;
-        //std::cout << "BIAS THIGN : " << costGradientB[nodeOut] * learnRate << std::endl;
-        costGradientB[nodeOut] = 0;
-
-        for (int nodeIn = 0; nodeIn < numNodesIn; nodeIn++) {
-            weights[nodeIn][nodeOut] -= costGradientW[nodeIn][nodeOut] * learnRate;
-            //std::cout << "WEIGHT THIGN : " << costGradientW[nodeIn][nodeOut] << std::endl;
-            costGradientW[nodeIn][nodeOut] = 0;
+TensorView<const double> NeuralNetwork::backPropagation(std::vector<NetworkLayer> &layers, Arena &arena,
+                                                        TensorView<const double> inputs,
+                                                        TensorView<const double> expectedOutputs,
+                                                        const std::function<void(int)> &layerDone) {
+    //Run the inputs through the network
+    TensorView<const double> outputs = calculateOutputs(layers, inputs, arena);
+
+    //Start from the derivatives of the cost with respect to the outputs
+    TensorView<const double> outputGradients = outputCostGradients(outputs, expectedOutputs, arena);
+
+    /* Each layer updates its gradients and hands the derivatives with respect to its inputs over to the layer
+       before it. The first layer has no layer before it, so it only needs its own gradients */
+    TensorView<const double> layerGradients = outputGradients;
+    for (int index = layers.size() - 1; index >= 0; index--) {
+        layerGradients = std::visit([&](auto &layer) {
+            return layer.backPropagate(layerGradients, arena, index > 0);
+        }, layers[index]);
+        if (layerDone) {
+            layerDone(index);
         }
     }
+    return outputs;
 }
 
-std::vector<double> Layer::outputLayerGradientProduct(std::vector<double> expectedOutputs) {
-    std::vector<double> gradientProducts(length());
+long NeuralNetwork::inputSize() const {
+    return numInputs;
+}
+
+int NeuralNetwork::layerCount() const {
+    return layers.size();
+}
 
-    for (int node = 0; node < length(); node++) {
-        //Evaluate partial derivatives for current node: cost/activation * activation/weightedInput
-        gradientProducts[node] = activationSigmoidDerivative(activations[node])
-                                 * calculateCostDerivative(activations[node], expectedOutputs[node]);
+const NetworkLayer &NeuralNetwork::layer(int index) const {
+    return layers[index];
+}
+
+long NeuralNetwork::parameterCount() const {
+    long count = 0;
+    for (auto &layer: layers) {
+        count += std::visit([](auto &layer) { return layer.parameterCount(); }, layer);
     }
+    return count;
+}
 
-    return gradientProducts;
+unsigned long NeuralNetwork::version() const {
+    std::shared_lock<std::shared_mutex> lock(parametersMutex);
+    return parametersVersion;
 }
 
-std::vector<double> Layer::hiddenLayerGradientProduct(Layer oldLayer, std::vector<double> oldGradientProducts) {
-    std::vector<double> gradientProducts(length());
+unsigned long NeuralNetwork::copyLayerParameters(int index, Tensor<double> &weights, Tensor<double> &biases) const {
+    std::shared_lock<std::shared_mutex> lock(parametersMutex);
+
+    if (auto *dense = std::get_if<DenseLayer>(&layers[index])) {
+        weights = Tensor<double>(dense->getWeights());
+        biases = Tensor<double>(dense->getBiases());
+    } else if (auto *convolution = std::get_if<Conv2DLayer>(&layers[index])) {
+        //Kernels are stored one output channel per row, so they are transposed to match the dense layers
+        weights = Tensor<double>(convolution->getWeights().transpose());
+        biases = Tensor<double>(convolution->getBiases());
+    } else {
+        throw std::invalid_argument("Layer " + std::to_string(index) + " has no weights");
+    }
+    return parametersVersion;
+}
 
-    for (int newGradientIndex = 0; newGradientIndex < gradientProducts.size(); newGradientIndex++) {
+std::uint64_t NeuralNetwork::seed() const {
+    return masterSeed;
+}
 
-        double gradientProductValue = 0;
-        for (int oldGradientIndex = 0; oldGradientIndex < oldGradientProducts.size(); oldGradientIndex++) {
-            //Partial derivative of the weighted input with respect to the input
-            gradientProductValue += oldLayer.weights[newGradientIndex][oldGradientIndex]
-                                    * oldGradientProducts[oldGradientIndex];
-        }
+void NeuralNetwork::initializeContext(TrainingContext &context, long batchSize) {
+    context.layers = layers;
+    context.gradients = Tensor<double>({parameters.size()});
+    bindLayers(context.layers, context.gradients);
+    context.scratch = Arena(workspaceBytes(batchSize));
+}
 
-        gradientProducts[newGradientIndex] = activationSigmoidDerivative(gradientProductValue);
-    }
+void NeuralNetwork::buildContexts(int shards) {
+    contexts.clear();
+    contexts.resize(shards);
 
-    return gradientProducts;
+    long shardBatchSize = (maxBatchSize + shards - 1) / shards;
+    for (auto &context: contexts) {
+        initializeContext(context, shardBatchSize);
+    }
 }
 
-void Layer::calculateGradients(std::vector<double> gradientProducts) {
-    for (int nodeOut = 0; nodeOut < numNodesOut; nodeOut++) {
-        for (int nodeIn = 0; nodeIn < numNodesIn; nodeIn++) {
-            costGradientW[nodeIn][nodeOut] += inputs[nodeIn] * gradientProducts[nodeOut];
-        }
+void NeuralNetwork::setTrainingMode(TrainingMode mode, int shards, ThreadPool *pool) {
+    this->pool = pool != nullptr ? pool : &ThreadPool::global();
+    trainingMode = mode;
 
-        costGradientB[nodeOut] += gradientProducts[nodeOut];
+    contexts.clear();
+    pipelineStages.clear();
+    stageThreads.reset();
+    if (mode == TrainingMode::Serial) {
+        return;
+    }
+    if (mode == TrainingMode::Pipeline) {
+        int stages = std::min(this->pool->threadCount(), static_cast<int>(layers.size()));
+        buildPipeline(stages, shards > 0 ? shards : defaultMicroBatchesPerStage * stages);
+        return;
     }
+    if (shards <= 0) {
+        shards = mode == TrainingMode::Deterministic ? defaultDeterministicShards : this->pool->threadCount();
+    }
+    buildContexts(shards);
 }
 
-// <-- LAYER IMPLEMENTATION END --> //
+TrainingMode NeuralNetwork::getTrainingMode() const {
+    return trainingMode;
+}
 
-// <-- NEURAL NETWORK IMPLEMENTATION --> //
+void NeuralNetwork::setAllReduce(RingAllReduce *ring, std::size_t bucketBytes) {
+    if (ring != nullptr && shared != nullptr) {
+        throw std::invalid_argument("A network cannot train with a ring and shared memory at once");
+    }
+    this->ring = ring;
+    gradientBuckets.clear();
+    if (ring == nullptr) {
+        return;
+    }
 
-NeuralNetwork::NeuralNetwork(std::vector<int> layersInfo) {
-    layers.resize(layersInfo.size() - 1);
-    for (int index = 0; index < layersInfo.size() - 1; index++) {
-        layers[index] = Layer(layersInfo[index], layersInfo[index + 1]);
+    //Layers are gathered from the last one, which the back propagation finishes first, until a bucket is big enough
+    long end = gradients.size();
+    for (int index = static_cast<int>(layers.size()) - 1; index >= 0; index--) {
+        long begin = parameterOffsets[index];
+        bool bigEnough = static_cast<std::size_t>(end - begin) * sizeof(double) >= bucketBytes;
+        if ((bigEnough || index == 0) && end > begin) {
+            gradientBuckets.push_back({index, begin, end});
+            end = begin;
+        }
     }
+
+    //Every process starts from the weights of process 0, whatever seed it was built with
+    std::unique_lock<std::shared_mutex> lock(parametersMutex);
+    ring->broadcast(parameters.data(), parameters.size());
+    parametersVersion++;
 }
 
-std::vector<double> NeuralNetwork::calculateOutputs(std::vector<double> inputs) {
-    //Give the first layer the inputs
-    layers[0].calculateOutputs(inputs);
+long NeuralNetwork::firstProcessSample(const Batch &batch) const {
+    if (ring != nullptr) {
+        return static_cast<long>(ring->rank()) * batch.size();
+    }
+    return shared != nullptr ? static_cast<long>(shared->worker()) * batch.size() : 0;
+}
 
-    //Calculate the output of each layer and feed it as an input to the next layer
-    for (int layer = 1; layer < layers.size(); layer++) {
-        layers[layer].calculateOutputs(layers[layer - 1].getActivations());
+void NeuralNetwork::setSharedParameters(SharedParameters *shared) {
+    if (shared != nullptr && ring != nullptr) {
+        throw std::invalid_argument("A network cannot train with shared memory and a ring at once");
+    }
+    std::unique_lock<std::shared_mutex> lock(parametersMutex);
+
+    if (shared != nullptr) {
+        shared->join(parameters);
+        parameters = shared->parameters();
+        gradients = shared->gradientSlot();
+    } else {
+        parameterStorage.view().copyFrom(parameters);
+        parameters = parameterStorage;
+        gradients = gradientStorage;
+    }
+    this->shared = shared;
+    bindLayers(layers, gradients);
+    parametersVersion++;
+
+    //The contexts and stages read the weights from wherever the network does
+    if (!contexts.empty()) {
+        buildContexts(static_cast<int>(contexts.size()));
+    }
+    if (!pipelineStages.empty()) {
+        buildPipeline(static_cast<int>(pipelineStages.size()), microBatches);
     }
-    return outputLayer().getActivations();
 }
 
-int NeuralNetwork::classify(std::vector<double> inputs) {
-    calculateOutputs(std::move(inputs));
-    double maxValue = std::numeric_limits<double>::lowest();
-    int maxNode = 0;
+long NeuralNetwork::parameterBufferSize() const {
+    return parameters.size();
+}
 
-    //Go through the output nodes and find the one with the highest activation value
-    for (int node = 0; node < outputLayer().length(); node++) {
-        if (outputLayer().getActivations()[node] > maxValue) {
-            maxValue = outputLayer().getActivations()[node];
-            maxNode = node;
+int NeuralNetwork::shardedBackPropagation(const Batch &batch) {
+    long shards = static_cast<long>(contexts.size());
+    std::vector<int> correctAnswers(shards, 0);
+
+    pool->run(shards, [&](long shard) {
+        long begin = batch.size() * shard / shards;
+        long end = batch.size() * (shard + 1) / shards;
+        if (begin == end) {
+            return;
         }
+
+        //The dropout masks of a sample only depend on the step and its index in the whole batch
+        TrainingContext &context = contexts[shard];
+        for (auto &layer: context.layers) {
+            if (auto *dropout = std::get_if<DropoutLayer>(&layer)) {
+                dropout->setPosition(trainingStep, firstProcessSample(batch) + begin);
+            }
+        }
+
+        context.scratch.reset();
+        TensorView<const double> outputs = backPropagation(context.layers, context.scratch,
+                                                           batch.inputs.view().slice(begin, end),
+                                                           batch.expectedOutputs.view().slice(begin, end));
+        correctAnswers[shard] = countCorrectAnswers(outputs, batch.labels, begin);
+
+        //The fast mode adds the gradients as soon as they are ready, in whatever order the shards finish
+        if (trainingMode == TrainingMode::Fast) {
+            std::lock_guard<std::mutex> lock(gradientsMutex);
+            double *shardGradients = context.gradients.data();
+            double *networkGradients = gradients.data();
+            for (long index = 0; index < gradients.size(); index++) {
+                networkGradients[index] += shardGradients[index];
+                shardGradients[index] = 0;
+            }
+        }
+    });
+
+    if (trainingMode == TrainingMode::Deterministic) {
+        reduceGradients();
     }
-    return maxNode;
+
+    /* The running statistics of the normalizations are averaged over the shards that had samples, in order: a shard
+       left empty by a batch smaller than the number of shards still holds the statistics of the last batch, and
+       would drag the average back to them */
+    for (int index = 0; index < layers.size(); index++) {
+        if (auto *normalization = std::get_if<BatchNormLayer>(&layers[index])) {
+            std::vector<BatchNormLayer *> replicas;
+            for (long shard = 0; shard < shards; shard++) {
+                if (batch.size() * (shard + 1) / shards > batch.size() * shard / shards) {
+                    replicas.push_back(&std::get<BatchNormLayer>(contexts[shard].layers[index]));
+                }
+            }
+            normalization->mergeRunningStatistics(replicas);
+            for (auto &context: contexts) {
+                std::get<BatchNormLayer>(context.layers[index]).copyRunningStatistics(*normalization);
+            }
+        }
+    }
+    trainingStep++;
+
+    int totalCorrect = 0;
+    for (int shardCorrect: correctAnswers) {
+        totalCorrect += shardCorrect;
+    }
+    return totalCorrect;
 }
 
-double NeuralNetwork::calculateCost(std::vector<double> inputs, std::vector<double> expectedOutputs) {
-    std::vector<double> outputs = calculateOutputs(std::move(inputs));
-    double cost = 0;
+long NeuralNetwork::trainHogwild(const BatchSource &nextBatch, int workers) {
+    if (ring != nullptr || shared != nullptr) {
+        throw std::invalid_argument("Hogwild training only runs within a single process");
+    }
+    ThreadPool &threads = pool != nullptr ? *pool : ThreadPool::global();
+    if (workers <= 0) {
+        workers = threads.threadCount();
+    }
 
-    //Add up the cost from each of the outputs
-    for (int nodeOut = 0; nodeOut < outputLayer().length(); nodeOut++) {
-        cost += outputLayer().calculateCost(outputs[nodeOut], expectedOutputs[nodeOut]);
+    std::vector<TrainingContext> workerContexts(workers);
+    for (auto &context: workerContexts) {
+        initializeContext(context, (maxBatchSize + workers - 1) / workers);
     }
-    return cost;
+
+    std::vector<long> batchCounts(workers, 0);
+    double *parameterValues = parameters.data();
+    long count = parameters.size();
+    threads.run(workers, [&](long worker) {
+        TrainingContext &context = workerContexts[worker];
+        double *gradientValues = context.gradients.data();
+        Batch batch;
+
+        while (nextBatch(static_cast<int>(worker), batch)) {
+            //Every batch of every worker gets its own dropout masks
+            for (auto &layer: context.layers) {
+                if (auto *dropout = std::get_if<DropoutLayer>(&layer)) {
+                    dropout->setPosition(batchCounts[worker] * workers + worker, 0);
+                }
+            }
+
+            context.scratch.reset();
+            backPropagation(context.layers, context.scratch, batch.inputs, batch.expectedOutputs);
+
+            //No lock on purpose, and the values a batch did not reach are left alone
+            double learnRate = 1.0 / batch.size();
+            for (long index = 0; index < count; index++) {
+                if (gradientValues[index] != 0) {
+                    parameterValues[index] -= gradientValues[index] * learnRate;
+                    gradientValues[index] = 0;
+                }
+            }
+            batchCounts[worker]++;
+        }
+    });
+
+    //A worker that got no batch still holds the statistics the training started from, which would dilute the others
+    for (int index = 0; index < layers.size(); index++) {
+        if (auto *normalization = std::get_if<BatchNormLayer>(&layers[index])) {
+            std::vector<BatchNormLayer *> replicas;
+            for (int worker = 0; worker < workers; worker++) {
+                if (batchCounts[worker] > 0) {
+                    replicas.push_back(&std::get<BatchNormLayer>(workerContexts[worker].layers[index]));
+                }
+            }
+            normalization->mergeRunningStatistics(replicas);
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(parametersMutex);
+    parametersVersion++;
+    long totalBatches = 0;
+    for (long batches: batchCounts) {
+        totalBatches += batches;
+    }
+    return totalBatches;
 }
 
-double NeuralNetwork::cost(std::vector<DataPoint> dataPoints) {
-    double totalCost = 0;
-    int datasetSize = dataPoints.size();
+long NeuralNetwork::trainHogwild(const std::vector<std::vector<DataPoint>> &streams, int batchSize) {
+    std::vector<std::size_t> positions(streams.size(), 0);
+    return trainHogwild([&](int worker, Batch &batch) {
+        const std::vector<DataPoint> &stream = streams[worker];
+        std::size_t begin = positions[worker];
+        if (begin >= stream.size()) {
+            return false;
+        }
+        std::size_t end = std::min(stream.size(), begin + static_cast<std::size_t>(batchSize));
+        batch = toBatch(std::vector<DataPoint>(stream.begin() + begin, stream.begin() + end));
+        positions[worker] = end;
+        return true;
+    }, static_cast<int>(streams.size()));
+}
+
+void NeuralNetwork::buildPipeline(int stages, int microBatchCount) {
+    pipelineStages.clear();
+    microBatches = std::max(microBatchCount, 1);
 
-    //Add up the costs from all data points
-    for (auto &dataPoint: dataPoints) {
-        totalCost += calculateCost(dataPoint.getInputData(), dataPoint.getExpectedOutputs());
+    //A stage ends once the layers so far did their share of the work, every stage keeping at least one layer
+    std::vector<double> work;
+    double totalWork = 0;
+    for (auto &layer: layers) {
+        work.push_back(estimateLayerWork(layer));
+        totalWork += work.back();
+    }
+    std::vector<int> firstLayers = {0};
+    double doneWork = 0;
+    for (int index = 0; index + 1 < layers.size() && firstLayers.size() < stages; index++) {
+        doneWork += work[index];
+        if (doneWork >= totalWork * static_cast<double>(firstLayers.size()) / stages) {
+            firstLayers.push_back(index + 1);
+        }
     }
+    firstLayers.push_back(static_cast<int>(layers.size()));
+
+    /* Stage s has at most (stages - s) micro-batches in flight. One more replica keeps the derivatives it hands to
+       the stage before alive until that stage used them: the replica of micro-batch m is only reused for m + the
+       replica count, which the stage before only starts once it is done with m */
+    int stageCount = static_cast<int>(firstLayers.size()) - 1;
+    long microBatchSize = (maxBatchSize + microBatches - 1) / microBatches;
+    pipelineStages.resize(stageCount);
+    for (int stage = 0; stage < stageCount; stage++) {
+        PipelineStage &pipelineStage = pipelineStages[stage];
+        pipelineStage.firstLayer = firstLayers[stage];
+        pipelineStage.endLayer = firstLayers[stage + 1];
+        int replicaCount = std::min(stageCount - stage + 1, microBatches);
+
+        std::size_t workspace = 0;
+        for (int index = pipelineStage.firstLayer; index < pipelineStage.endLayer; index++) {
+            workspace += std::visit([&](auto &layer) { return layer.workspaceBytes(microBatchSize); }, layers[index]);
+        }
+        if (stage == stageCount - 1) {
+            long outputSize = std::visit([](auto &layer) { return layer.getOutputShape().size(); }, layers.back());
+            workspace += Arena::bytesFor<double>(microBatchSize * outputSize);
+        }
 
-    //Return the average cost between the data points
-    return totalCost / datasetSize;
+        for (int replica = 0; replica < replicaCount; replica++) {
+            pipelineStage.replicas.emplace_back(layers.begin() + pipelineStage.firstLayer,
+                                                layers.begin() + pipelineStage.endLayer);
+            bindLayers(pipelineStage.replicas.back(), gradients, pipelineStage.firstLayer);
+            pipelineStage.arenas.emplace_back(workspace);
+        }
+        pipelineStage.outputGradients.resize(replicaCount);
+        pipelineStage.activationsIn = std::make_unique<BoundedQueue<TensorView<const double>>>(replicaCount);
+        pipelineStage.gradientsIn = std::make_unique<BoundedQueue<TensorView<const double>>>(replicaCount);
+    }
+
+    //The caller of gradientDescent runs the first stage, the pool has a worker for each of the others
+    if (!stageThreads || stageThreads->threadCount() != stageCount) {
+        stageThreads = std::make_unique<ThreadPool>(stageCount);
+    }
 }
 
-Layer NeuralNetwork::outputLayer() {
-    return layers[layers.size() - 1];
+int NeuralNetwork::pipelinedBackPropagation(const Batch &batch) {
+    long count = std::min<long>(microBatches, batch.size());
+    std::vector<long> bounds;
+    for (long microBatch = 0; microBatch <= count; microBatch++) {
+        bounds.push_back(batch.size() * microBatch / count);
+    }
+    for (auto &stage: pipelineStages) {
+        stage.activationsIn->reset();
+        stage.gradientsIn->reset();
+    }
+
+    /* Every stage needs a thread of its own, since it waits on the others: stages sharing a thread (inside a task,
+       or with fewer threads than stages) would wait forever on a queue. Jobs the stages start run on their thread */
+    std::vector<int> correctAnswers(count, 0);
+    stageThreads->runConcurrently(static_cast<long>(pipelineStages.size()), [&](long stage) {
+        runPipelineStage(static_cast<int>(stage), batch, bounds, correctAnswers);
+    });
+
+    //The running statistics of the normalizations end up in the replica of the last micro-batch
+    for (auto &stage: pipelineStages) {
+        std::vector<NetworkLayer> &lastReplica = stage.replicas[(count - 1) % stage.replicas.size()];
+        for (int index = stage.firstLayer; index < stage.endLayer; index++) {
+            if (auto *normalization = std::get_if<BatchNormLayer>(&layers[index])) {
+                normalization->copyRunningStatistics(std::get<BatchNormLayer>(lastReplica[index - stage.firstLayer]));
+            }
+        }
+    }
+    trainingStep++;
+
+    int totalCorrect = 0;
+    for (int microBatchCorrect: correctAnswers) {
+        totalCorrect += microBatchCorrect;
+    }
+    return totalCorrect;
 }
 
-void NeuralNetwork::gradientDescent(std::vector<DataPoint> dataPoints) {
-    double learnRate = 1;
-    int correctAnswers = 0;
+void NeuralNetwork::runPipelineStage(int stage, const Batch &batch, const std::vector<long> &bounds,
+                                     std::vector<int> &correctAnswers) {
+    PipelineStage &pipelineStage = pipelineStages[stage];
+    int stageCount = static_cast<int>(pipelineStages.size());
+    bool lastStage = stage == stageCount - 1;
+    int count = static_cast<int>(bounds.size()) - 1;
+
+    //Each returns false when another stage failed and closed the queues
+    auto forward = [&](int microBatch) {
+        TensorView<const double> inputs;
+        if (stage == 0) {
+            inputs = batch.inputs.view().slice(bounds[microBatch], bounds[microBatch + 1]);
+        } else if (!pipelineStage.activationsIn->pop(inputs)) {
+            return false;
+        }
 
-    for (auto &dataPoint: dataPoints) {
-        int choice = classify(dataPoint.getInputData());
-        //std::cout << choice << " ? " << findCorrectActivationIndex(dataPoint.getExpectedOutputs()) << " | ";
-        if (choice == findCorrectActivationIndex(dataPoint.getExpectedOutputs())) {
-            correctAnswers += 1;
+        int replicaCount = static_cast<int>(pipelineStage.replicas.size());
+        int replica = microBatch % replicaCount;
+        Arena &arena = pipelineStage.arenas[replica];
+        arena.reset();
+
+        /* The running statistics go from each micro-batch to the next, as if they were batches trained on one after
+           the other, so they do not depend on the number of replicas either */
+        std::vector<NetworkLayer> &stageLayers = pipelineStage.replicas[replica];
+        for (int index = 0; index < stageLayers.size(); index++) {
+            if (auto *dropout = std::get_if<DropoutLayer>(&stageLayers[index])) {
+                dropout->setPosition(trainingStep, firstProcessSample(batch) + bounds[microBatch]);
+            } else if (auto *normalization = std::get_if<BatchNormLayer>(&stageLayers[index])) {
+                const NetworkLayer &previous = microBatch == 0 ? layers[pipelineStage.firstLayer + index]
+                        : pipelineStage.replicas[(microBatch - 1) % replicaCount][index];
+                normalization->copyRunningStatistics(std::get<BatchNormLayer>(previous));
+            }
+        }
+        TensorView<const double> outputs = calculateOutputs(stageLayers, inputs, arena);
+
+        if (!lastStage) {
+            return pipelineStages[stage + 1].activationsIn->push(outputs);
+        }
+        TensorView<const double> expectedOutputs = batch.expectedOutputs.view().slice(bounds[microBatch],
+                                                                                      bounds[microBatch + 1]);
+        pipelineStage.outputGradients[replica] = outputCostGradients(outputs, expectedOutputs, arena);
+        correctAnswers[microBatch] = countCorrectAnswers(outputs, batch.labels, bounds[microBatch]);
+        return true;
+    };
+
+    auto backward = [&](int microBatch) {
+        int replica = microBatch % static_cast<int>(pipelineStage.replicas.size());
+        TensorView<const double> layerGradients;
+        if (lastStage) {
+            layerGradients = pipelineStage.outputGradients[replica];
+        } else if (!pipelineStage.gradientsIn->pop(layerGradients)) {
+            return false;
+        }
+
+        //Only the very first layer of the network has nobody to hand the derivatives of its inputs to
+        std::vector<NetworkLayer> &stageLayers = pipelineStage.replicas[replica];
+        for (int index = static_cast<int>(stageLayers.size()) - 1; index >= 0; index--) {
+            layerGradients = std::visit([&](auto &layer) {
+                return layer.backPropagate(layerGradients, pipelineStage.arenas[replica], stage > 0 || index > 0);
+            }, stageLayers[index]);
         }
-        backPropagation(dataPoint.getInputData(), dataPoint.getExpectedOutputs());
+        return stage == 0 || pipelineStages[stage - 1].gradientsIn->push(layerGradients);
+    };
+
+    /* 1F1B: a stage runs the forward passes the stages after it need to get going, then alternates a forward
+       pass with the backward pass of the oldest micro-batch it holds, and finishes the backward passes left */
+    int warmup = std::min(stageCount - stage - 1, count);
+    try {
+        bool running = true;
+        for (int microBatch = 0; microBatch < warmup && running; microBatch++) {
+            running = forward(microBatch);
+        }
+        for (int microBatch = warmup; microBatch < count && running; microBatch++) {
+            running = forward(microBatch) && backward(microBatch - warmup);
+        }
+        for (int microBatch = count - warmup; microBatch < count && running; microBatch++) {
+            running = backward(microBatch);
+        }
+    } catch (...) {
+        for (auto &other: pipelineStages) {
+            other.activationsIn->close();
+            other.gradientsIn->close();
+        }
+        throw;
     }
+}
 
-    std::cout << "Accuracy: " << correctAnswers << " / " << dataPoints.size() << ", ";
-    applyAllGradients(learnRate / dataPoints.size());
+void NeuralNetwork::reduceGradients() {
+    long shards = static_cast<long>(contexts.size());
+    std::vector<double *> shardGradients;
+    for (auto &context: contexts) {
+        shardGradients.push_back(context.gradients.data());
+    }
+    double *networkGradients = gradients.data();
+
+    /* Pairwise tree: shard 1 goes into shard 0, 3 into 2..., then 2 into 0, and so on. Each chunk of the buffer
+       goes through the whole tree on its own, so the order of the additions of a value never depends on the threads */
+    pool->parallelFor(0, gradients.size(), parallelChunkSize, [&](long begin, long end) {
+        for (long stride = 1; stride < shards; stride *= 2) {
+            for (long shard = 0; shard + stride < shards; shard += 2 * stride) {
+                double *target = shardGradients[shard];
+                double *source = shardGradients[shard + stride];
+                for (long index = begin; index < end; index++) {
+                    target[index] += source[index];
+                    source[index] = 0;
+                }
+            }
+        }
+        for (long index = begin; index < end; index++) {
+            networkGradients[index] += shardGradients[0][index];
+            shardGradients[0][index] = 0;
+        }
+    });
 }
 
-void NeuralNetwork::applyAllGradients(double learnRate) {
+std::vector<long> NeuralNetwork::activationSizes() const {
+    std::vector<long> sizes = {numInputs};
     for (auto &layer: layers) {
-        layer.applyGradients(learnRate);
+        sizes.push_back(std::visit([](auto &layer) { return layer.getOutputShape().size(); }, layer));
     }
+    return sizes;
 }
 
-void NeuralNetwork::backPropagation(std::vector<double> inputs, std::vector<double> expectedOutputs) {
-    //Run the inputs through the network
-    calculateOutputs(std::move(inputs));
-//    for (auto &var : outputLayer().getActivations()) {
-//        std::cout << var << ", ";
-//    }
-//    std::cout << std::endl;
-
-    //Update the gradients of the output layer
-    std::vector<double> gradientProducts = outputLayer().outputLayerGradientProduct(std::move(expectedOutputs));
-    outputLayer().calculateGradients(gradientProducts);
+std::vector<Tensor<double>> NeuralNetwork::layerActivations(TensorView<const double> inputs) const {
+    std::shared_lock<std::shared_mutex> lock(parametersMutex);
+    std::vector<Tensor<double>> activations;
+    activations.emplace_back(inputs);
 
-    //Calculate the gradients for each of the hidden layers
-    for (int layer = layers.size() - 2; layer >= 0; layer--) {
-        gradientProducts = layers[layer].hiddenLayerGradientProduct(layers[layer + 1], gradientProducts);
-        layers[layer].calculateGradients(gradientProducts);
+    //Every layer computes a batch with a single sample, copied out of the arena
+    Arena arena(sampleWorkspaceBytes);
+    for (auto &outputs: computeLayerOutputs(inputs.reshape({1, inputs.size()}), arena)) {
+        activations.emplace_back(outputs.row(0));
     }
+    return activations;
 }
 
+int NeuralNetwork::foldBatchNorm() {
+    std::unique_lock<std::shared_mutex> lock(parametersMutex);
+    int foldedCount = 0;
 
-// <-- NEURAL NETWORK IMPLEMENTATION END --> //
+    for (int index = 1; index < layers.size(); index++) {
+        auto *normalization = std::get_if<BatchNormLayer>(&layers[index]);
+        if (normalization == nullptr || normalization->isFolded()) {
+            continue;
+        }
+
+        //The normalization applies to the weighted inputs only when nothing comes between them
+        Tensor<double> scales, shifts;
+        normalization->inferenceTransform(scales, shifts);
+        if (auto *dense = std::get_if<DenseLayer>(&layers[index - 1]);
+                dense != nullptr && dense->getActivationFunction() == ActivationFunction::Linear) {
+            dense->foldScaleAndShift(scales, shifts);
+        } else if (auto *convolution = std::get_if<Conv2DLayer>(&layers[index - 1]);
+                convolution != nullptr && convolution->getActivationFunction() == ActivationFunction::Linear) {
+            convolution->foldScaleAndShift(scales, shifts);
+        } else {
+            continue;
+        }
+        normalization->markFolded();
+        foldedCount++;
+    }
+
+    if (foldedCount > 0) {
+        parametersVersion++;
 
-DataPoint::DataPoint(std::vector<double> inputData, std::vector<double> expectedOutputs) {
-    this->inputData = std::move(inputData);
-    this->expectedOutputs = std::move(expectedOutputs);
+        //The training contexts and stages are copies of the layers, so they have to be folded too
+        if (!contexts.empty()) {
+            buildContexts(static_cast<int>(contexts.size()));
+        }
+        if (!pipelineStages.empty()) {
+            buildPipeline(static_cast<int>(pipelineStages.size()), microBatches);
+        }
+    }
+    return foldedCount;
 }
 
+// <-- NEURAL NETWORK IMPLEMENTATION END --> //
+
+DataPoint::DataPoint(const std::vector<double> &inputData, const std::vector<double> &expectedOutputs)
+        : inputData(inputData), expectedOutputs(expectedOutputs) {}
+
 void DataPoint::print() {
     std::cout << "Inputs: ";
     for (auto &input : inputData) {
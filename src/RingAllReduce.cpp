@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include "headers/RingAllReduce.h"
+
+using namespace neuralNet;
+
+// <-- RING ALL-REDUCE IMPLEMENTATION --> //
+
+//Values the broadcast forwards at a time, so every process of the chain is busy at once rather than one after another
+constexpr long broadcastChunkSize = 64 * 1024;
+
+//Splits "host:port" in two, throws std::invalid_argument when it is not in that form
+void parseAddress(const std::string &address, std::string &host, std::uint16_t &port) {
+    std::size_t colon = address.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == address.size()) {
+        throw std::invalid_argument("Expected host:port, got \"" + address + "\"");
+    }
+    host = address.substr(0, colon);
+    int number = std::stoi(address.substr(colon + 1));
+    if (number <= 0 || number > 65535) {
+        throw std::invalid_argument("Bad port in \"" + address + "\"");
+    }
+    port = static_cast<std::uint16_t>(number);
+}
+
+RingAllReduce::RingAllReduce(int rank, const std::vector<std::string> &addresses, int timeoutSeconds)
+        : processRank(rank), processCount(static_cast<int>(addresses.size())) {
+    if (rank < 0 || rank >= processCount) {
+        throw std::invalid_argument("Rank " + std::to_string(rank) + " is not in a ring of "
+                                    + std::to_string(processCount) + " processes");
+    }
+    if (processCount == 1) {
+        return;
+    }
+
+    std::string host, nextHost;
+    std::uint16_t port, nextPort;
+    parseAddress(addresses[rank], host, port);
+    parseAddress(addresses[(rank + 1) % processCount], nextHost, nextPort);
+
+    /* Listen first, so the process before can connect while this one connects to the next. Connecting does not
+       wait for the peer to accept, so no process waits on another in a circle */
+    Socket listener = Socket::listen(port);
+    next = Socket::connect(nextHost, nextPort, timeoutSeconds);
+    previous = listener.accept(timeoutSeconds);
+
+    //Every process tells the next who it is, which catches rings built with different addresses
+    std::int32_t ownRank = rank;
+    std::int32_t previousRank = -1;
+    Socket::exchange(next, &ownRank, sizeof(ownRank), previous, &previousRank, sizeof(previousRank));
+    if (previousRank != (rank + processCount - 1) % processCount) {
+        throw std::runtime_error("Process " + std::to_string(rank) + " was reached by process "
+                                 + std::to_string(previousRank) + " instead of the one before it");
+    }
+
+    worker = std::thread([this]() { workerLoop(); });
+}
+
+RingAllReduce::~RingAllReduce() {
+    if (worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stopping = true;
+        }
+        workAdded.notify_all();
+        worker.join();
+    }
+}
+
+int RingAllReduce::rank() const {
+    return processRank;
+}
+
+int RingAllReduce::size() const {
+    return processCount;
+}
+
+void RingAllReduce::workerLoop() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    while (true) {
+        workAdded.wait(lock, [this]() { return stopping || !pending.empty(); });
+        if (pending.empty()) {
+            return;
+        }
+        Span span = pending.front();
+        pending.pop_front();
+        busy = true;
+        lock.unlock();
+
+        //After an error the ring is out of step, so the rest of the queue is dropped
+        try {
+            reduce(span.values, span.count);
+        } catch (...) {
+            lock.lock();
+            if (!error) {
+                error = std::current_exception();
+            }
+            pending.clear();
+            lock.unlock();
+        }
+
+        lock.lock();
+        busy = false;
+        workDone.notify_all();
+    }
+}
+
+void RingAllReduce::reduce(double *values, long count) {
+    int processes = processCount;
+    auto segmentBegin = [&](int segment) { return count * segment / processes; };
+    receiveBuffer.resize(count / processes + 1);
+
+    /* Reduce-scatter: at step s every process sends segment (rank - s) and adds the one before it into its own
+       values, so after n - 1 steps process r holds the whole sum of segment r + 1 */
+    for (int step = 0; step < processes - 1; step++) {
+        int sendSegment = (processRank - step + processes) % processes;
+        int receiveSegment = (processRank - step - 1 + processes) % processes;
+        long sendBegin = segmentBegin(sendSegment);
+        long receiveBegin = segmentBegin(receiveSegment);
+        long receiveCount = segmentBegin(receiveSegment + 1) - receiveBegin;
+
+        Socket::exchange(next, values + sendBegin, (segmentBegin(sendSegment + 1) - sendBegin) * sizeof(double),
+                         previous, receiveBuffer.data(), receiveCount * sizeof(double));
+        double *target = values + receiveBegin;
+        for (long index = 0; index < receiveCount; index++) {
+            target[index] += receiveBuffer[index];
+        }
+    }
+
+    //All-gather: the finished segments go around the ring once more, replacing the partial sums
+    for (int step = 0; step < processes - 1; step++) {
+        int sendSegment = (processRank + 1 - step + processes) % processes;
+        int receiveSegment = (processRank - step + processes) % processes;
+        long sendBegin = segmentBegin(sendSegment);
+        long receiveBegin = segmentBegin(receiveSegment);
+
+        Socket::exchange(next, values + sendBegin, (segmentBegin(sendSegment + 1) - sendBegin) * sizeof(double),
+                         previous, values + receiveBegin,
+                         (segmentBegin(receiveSegment + 1) - receiveBegin) * sizeof(double));
+    }
+}
+
+void RingAllReduce::startAllReduce(double *values, long count) {
+    if (processCount == 1 || count == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        pending.push_back({values, count});
+    }
+    workAdded.notify_one();
+}
+
+void RingAllReduce::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    workDone.wait(lock, [this]() { return pending.empty() && !busy; });
+    if (error) {
+        std::exception_ptr thrown = error;
+        error = nullptr;
+        std::rethrow_exception(thrown);
+    }
+}
+
+void RingAllReduce::allReduce(double *values, long count) {
+    startAllReduce(values, count);
+    wait();
+}
+
+void RingAllReduce::broadcast(double *values, long count) {
+    if (processCount == 1) {
+        return;
+    }
+
+    //The values go down the chain 0 -> 1 -> ... -> n - 1, a chunk at a time
+    wait();
+    bool receives = processRank != 0;
+    bool sends = processRank != processCount - 1;
+    for (long begin = 0; begin < count; begin += broadcastChunkSize) {
+        std::size_t bytes = std::min(broadcastChunkSize, count - begin) * sizeof(double);
+        if (receives) {
+            previous.receiveAll(values + begin, bytes);
+        }
+        if (sends) {
+            next.sendAll(values + begin, bytes);
+        }
+    }
+}
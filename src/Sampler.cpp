@@ -0,0 +1,76 @@
+#include <stdexcept>
+#include <string>
+#include "headers/Sampler.h"
+
+using namespace neuralNet;
+
+// <-- SAMPLER IMPLEMENTATION --> //
+
+Sampler::Sampler(long sampleCount, int batchSize, std::uint64_t seed, int rank, int rankCount, long epochLimit)
+        : sampleCount(sampleCount), batchSize(batchSize), key(Philox::key(seed)), rank(rank), rankCount(rankCount),
+          epochLimit(epochLimit) {
+    if (rankCount < 1 || rank < 0 || rank >= rankCount) {
+        throw std::invalid_argument("Rank " + std::to_string(rank) + " is not one of " + std::to_string(rankCount));
+    }
+    if (batchSize < 1 || batchSize > sampleCount / rankCount) {
+        throw std::invalid_argument("Batches of " + std::to_string(batchSize) + " do not fit in the "
+                                    + std::to_string(sampleCount / rankCount) + " samples of a rank");
+    }
+
+    //The smallest block covering every position, so walking again takes fewer than 4 tries on average
+    while ((1ull << 2 * halfBits) < static_cast<std::uint64_t>(sampleCount)) {
+        halfBits++;
+    }
+}
+
+long Sampler::sampleAt(long epoch, long position) const {
+    std::uint64_t mask = (1ull << halfBits) - 1;
+    auto value = static_cast<std::uint64_t>(position);
+    do {
+        std::uint64_t left = value >> halfBits;
+        std::uint64_t right = value & mask;
+        for (int round = 0; round < feistelRounds; round++) {
+            Philox::Counter numbers = Philox::generate({static_cast<std::uint32_t>(right),
+                                                        static_cast<std::uint32_t>(right >> 32),
+                                                        static_cast<std::uint32_t>(epoch),
+                                                        static_cast<std::uint32_t>(round)}, key);
+            std::uint64_t mixed = (static_cast<std::uint64_t>(numbers[1]) << 32 | numbers[0]) & mask;
+            std::uint64_t next = left ^ mixed;
+            left = right;
+            right = next;
+        }
+        value = left << halfBits | right;
+    } while (value >= static_cast<std::uint64_t>(sampleCount));
+    return static_cast<long>(value);
+}
+
+long Sampler::batchesPerEpoch() const {
+    return sampleCount / rankCount / batchSize;
+}
+
+long Sampler::epoch() const {
+    return currentEpoch;
+}
+
+void Sampler::setEpoch(long epoch) {
+    currentEpoch = epoch;
+    nextBatch = 0;
+}
+
+bool Sampler::operator()(std::vector<int> &indices) {
+    if (nextBatch == batchesPerEpoch()) {
+        currentEpoch++;
+        nextBatch = 0;
+    }
+    if (epochLimit > 0 && currentEpoch >= epochLimit) {
+        return false;
+    }
+
+    indices.resize(batchSize);
+    long firstPosition = nextBatch * batchSize;
+    for (int sample = 0; sample < batchSize; sample++) {
+        indices[sample] = static_cast<int>(sampleAt(currentEpoch, (firstPosition + sample) * rankCount + rank));
+    }
+    nextBatch++;
+    return true;
+}
@@ -0,0 +1,194 @@
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include "headers/ShardedDataset.h"
+
+using namespace neuralNet;
+using namespace neuralNet::shardFormat;
+
+// <-- HELPER FUNCTIONS --> //
+
+//Bytes of a record: the label and the inputs
+std::size_t recordBytes(int inputSize) {
+    return sizeof(std::uint32_t) + static_cast<std::size_t>(inputSize);
+}
+
+std::string shardFormat::shardPath(const std::string &basePath, int shard) {
+    std::string number = std::to_string(shard);
+    return basePath + "-" + std::string(number.size() < 5 ? 5 - number.size() : 0, '0') + number + ".shard";
+}
+
+// <-- SHARD WRITER IMPLEMENTATION --> //
+
+ShardWriter::ShardWriter(std::string basePath, int inputSize, int numClasses, int samplesPerShard,
+                         double inputScale)
+        : basePath(std::move(basePath)), inputSize(inputSize), numClasses(numClasses),
+          samplesPerShard(samplesPerShard), inputScale(inputScale) {
+    if (inputSize < 1 || numClasses < 1 || samplesPerShard < 1) {
+        throw std::invalid_argument("A sharded dataset needs inputs, classes and samples in every shard");
+    }
+    if (sizeof(ShardHeader) + samplesPerShard * recordBytes(inputSize) >= 1ull << offsetBits) {
+        throw std::invalid_argument("The shards would be too big for the offsets of the index");
+    }
+}
+
+void ShardWriter::writeShardHeader() {
+    ShardHeader header{shardMagic, samplesInShard, shardCount - 1, inputSize};
+    shard.seekp(0);
+    shard.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+void ShardWriter::closeShard() {
+    if (shard.is_open()) {
+        writeShardHeader();
+        shard.close();
+        if (!shard) {
+            throw std::runtime_error("Could not write " + shardPath(basePath, shardCount - 1));
+        }
+    }
+}
+
+void ShardWriter::add(const std::uint8_t *sampleInputs, int label) {
+    if (label < 0 || label >= numClasses) {
+        throw std::out_of_range("Dataset label " + std::to_string(label) + " is not a valid class");
+    }
+    if (entries.size() == INT_MAX) {
+        throw std::length_error("A sharded dataset holds at most " + std::to_string(INT_MAX) + " samples");
+    }
+
+    //The header of a new shard is written again with its sample count once it is full
+    if (!shard.is_open() || samplesInShard == samplesPerShard) {
+        if (shardCount == 1 << (64 - offsetBits)) {
+            throw std::length_error("A sharded dataset has too many shards for its index");
+        }
+        closeShard();
+        shard.clear();
+        shard.open(shardPath(basePath, shardCount), std::ios::binary | std::ios::trunc);
+        shardCount++;
+        samplesInShard = 0;
+        writeShardHeader();
+    }
+
+    //Records are written one after the other, right after the header
+    std::uint64_t offset = sizeof(ShardHeader) + samplesInShard * recordBytes(inputSize);
+    entries.push_back(static_cast<std::uint64_t>(shardCount - 1) << offsetBits | offset);
+    auto storedLabel = static_cast<std::uint32_t>(label);
+    shard.write(reinterpret_cast<const char *>(&storedLabel), sizeof(storedLabel));
+    shard.write(reinterpret_cast<const char *>(sampleInputs), inputSize);
+    samplesInShard++;
+    if (!shard) {
+        throw std::runtime_error("Could not write " + shardPath(basePath, shardCount - 1));
+    }
+}
+
+void ShardWriter::finish() {
+    closeShard();
+
+    std::ofstream file(basePath + ".index", std::ios::binary | std::ios::trunc);
+    IndexHeader header{indexMagic, static_cast<std::int64_t>(entries.size()), inputSize, numClasses, shardCount, 0,
+                       inputScale};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(entries.data()),
+               static_cast<std::streamsize>(entries.size() * sizeof(std::uint64_t)));
+    if (!file) {
+        throw std::runtime_error("Could not write " + basePath + ".index");
+    }
+}
+
+void neuralNet::writeShards(const Dataset &dataset, const std::string &basePath, int samplesPerShard) {
+    ShardWriter writer(basePath, dataset.sampleSize(), dataset.classes(), samplesPerShard, dataset.scale());
+    for (int index = 0; index < dataset.size(); index++) {
+        writer.add(dataset.sample(index), dataset.label(index));
+    }
+    writer.finish();
+}
+
+// <-- SHARDED DATASET IMPLEMENTATION --> //
+
+ShardedDataset::ShardedDataset(const std::string &basePath) : basePath(basePath), index(basePath + ".index") {
+    IndexHeader header{};
+    if (index.size() >= sizeof(header)) {
+        std::memcpy(&header, index.data(), sizeof(header));
+    }
+    if (index.size() < sizeof(header) || header.magic != indexMagic || header.sampleCount > INT_MAX
+        || index.size() != sizeof(header) + header.sampleCount * sizeof(std::uint64_t)) {
+        throw std::runtime_error(basePath + ".index is not the index of a sharded dataset");
+    }
+    sampleCount = static_cast<int>(header.sampleCount);
+    inputSize = header.inputSize;
+    numClasses = header.numClasses;
+    inputScale = header.inputScale;
+    entries = reinterpret_cast<const std::uint64_t *>(index.data() + sizeof(header));
+
+    //Mapping only reserves addresses, the pages of a shard are read when its samples are
+    for (int shard = 0; shard < header.shardCount; shard++) {
+        std::string path = shardPath(basePath, shard);
+        shards.emplace_back(path);
+        ShardHeader shardHeader{};
+        if (shards.back().size() >= sizeof(shardHeader)) {
+            std::memcpy(&shardHeader, shards.back().data(), sizeof(shardHeader));
+        }
+        if (shards.back().size() < sizeof(shardHeader) || shardHeader.magic != shardMagic
+            || shardHeader.shard != shard || shardHeader.inputSize != inputSize
+            || shards.back().size() != sizeof(shardHeader) + shardHeader.sampleCount * recordBytes(inputSize)) {
+            throw std::runtime_error(path + " is not shard " + std::to_string(shard) + " of " + basePath);
+        }
+    }
+}
+
+const std::uint8_t *ShardedDataset::record(int index) const {
+    //Entries are checked as they are read, so opening a dataset does not walk the whole index
+    std::uint64_t entry = entries[index];
+    std::uint64_t shard = entry >> offsetBits;
+    std::uint64_t offset = entry & ((1ull << offsetBits) - 1);
+    if (shard >= shards.size() || offset + recordBytes(inputSize) > shards[shard].size()) {
+        throw std::runtime_error(basePath + ".index points sample " + std::to_string(index)
+                                 + " outside of the shards");
+    }
+    return shards[shard].data() + offset;
+}
+
+int ShardedDataset::size() const {
+    return sampleCount;
+}
+
+int ShardedDataset::sampleSize() const {
+    return inputSize;
+}
+
+int ShardedDataset::classes() const {
+    return numClasses;
+}
+
+double ShardedDataset::scale() const {
+    return inputScale;
+}
+
+int ShardedDataset::shardCount() const {
+    return static_cast<int>(shards.size());
+}
+
+const std::uint8_t *ShardedDataset::sample(int index) const {
+    return record(index) + sizeof(std::uint32_t);
+}
+
+int ShardedDataset::label(int index) const {
+    std::uint32_t storedLabel;
+    std::memcpy(&storedLabel, record(index), sizeof(storedLabel));
+    if (storedLabel >= static_cast<std::uint32_t>(numClasses)) {
+        throw std::runtime_error("Sample " + std::to_string(index) + " of " + basePath + " has label "
+                                 + std::to_string(storedLabel) + ", which is not a class");
+    }
+    return static_cast<int>(storedLabel);
+}
+
+void ShardedDataset::loadBatch(const std::vector<int> &indices, Batch &batch) const {
+    int count = static_cast<int>(indices.size());
+    batch.reshape(count, inputSize, numClasses);
+    batch.expectedOutputs.fill(0);
+
+    for (int row = 0; row < count; row++) {
+        batch.setSample(row, sample(indices[row]), inputScale, label(indices[row]));
+    }
+}
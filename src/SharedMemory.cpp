@@ -0,0 +1,165 @@
+#include <stdexcept>
+#include <utility>
+#include "headers/SharedMemory.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace neuralNet;
+
+// <-- SHARED MEMORY IMPLEMENTATION --> //
+
+SharedMemory::SharedMemory(SharedMemory &&other) noexcept
+        : address(std::exchange(other.address, nullptr)), bytes(std::exchange(other.bytes, 0)),
+          name(std::move(other.name)), owner(std::exchange(other.owner, false)),
+          mapping(std::exchange(other.mapping, nullptr)) {}
+
+SharedMemory &SharedMemory::operator=(SharedMemory &&other) noexcept {
+    if (this != &other) {
+        release();
+        address = std::exchange(other.address, nullptr);
+        bytes = std::exchange(other.bytes, 0);
+        name = std::move(other.name);
+        owner = std::exchange(other.owner, false);
+        mapping = std::exchange(other.mapping, nullptr);
+    }
+    return *this;
+}
+
+SharedMemory::~SharedMemory() {
+    release();
+}
+
+void *SharedMemory::data() const {
+    return address;
+}
+
+std::size_t SharedMemory::size() const {
+    return bytes;
+}
+
+#ifdef _WIN32
+
+//The mapping goes away with the last handle to it, so the creator has nothing to remove
+void SharedMemory::release() {
+    if (address != nullptr) {
+        UnmapViewOfFile(address);
+        address = nullptr;
+    }
+    if (mapping != nullptr) {
+        CloseHandle(static_cast<HANDLE>(mapping));
+        mapping = nullptr;
+    }
+}
+
+SharedMemory SharedMemory::create(const std::string &name, std::size_t bytes) {
+    SharedMemory memory;
+    memory.name = name;
+    memory.bytes = bytes;
+    memory.owner = true;
+    memory.mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(static_cast<unsigned long long>(bytes) >> 32),
+                                        static_cast<DWORD>(bytes), name.c_str());
+    if (memory.mapping == nullptr) {
+        throw std::runtime_error("Could not create shared memory " + name);
+    }
+    memory.address = MapViewOfFile(static_cast<HANDLE>(memory.mapping), FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (memory.address == nullptr) {
+        throw std::runtime_error("Could not map shared memory " + name);
+    }
+    return memory;
+}
+
+SharedMemory SharedMemory::open(const std::string &name, std::size_t bytes) {
+    SharedMemory memory;
+    memory.name = name;
+    memory.bytes = bytes;
+    memory.mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+    if (memory.mapping == nullptr) {
+        throw std::runtime_error("Could not open shared memory " + name);
+    }
+    memory.address = MapViewOfFile(static_cast<HANDLE>(memory.mapping), FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (memory.address == nullptr) {
+        throw std::runtime_error("Could not map shared memory " + name);
+    }
+    return memory;
+}
+
+#else
+
+//POSIX names start with a single slash
+std::string objectName(const std::string &name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+void SharedMemory::release() {
+    if (address != nullptr) {
+        munmap(address, bytes);
+        address = nullptr;
+    }
+    if (owner) {
+        shm_unlink(objectName(name).c_str());
+        owner = false;
+    }
+}
+
+SharedMemory SharedMemory::create(const std::string &name, std::size_t bytes) {
+    std::string object = objectName(name);
+    shm_unlink(object.c_str());
+    int descriptor = shm_open(object.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (descriptor < 0) {
+        throw std::runtime_error("Could not create shared memory " + name + ": " + std::strerror(errno));
+    }
+
+    SharedMemory memory;
+    memory.name = name;
+    memory.owner = true;
+    if (ftruncate(descriptor, static_cast<off_t>(bytes)) != 0) {
+        ::close(descriptor);
+        throw std::runtime_error("Could not size shared memory " + name + ": " + std::strerror(errno));
+    }
+    void *address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    ::close(descriptor);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Could not map shared memory " + name + ": " + std::strerror(errno));
+    }
+    memory.address = address;
+    memory.bytes = bytes;
+    return memory;
+}
+
+SharedMemory SharedMemory::open(const std::string &name, std::size_t bytes) {
+    int descriptor = shm_open(objectName(name).c_str(), O_RDWR, 0600);
+    if (descriptor < 0) {
+        throw std::runtime_error("Could not open shared memory " + name + ": " + std::strerror(errno));
+    }
+
+    //The creator may not have sized it yet
+    struct stat status{};
+    if (fstat(descriptor, &status) != 0 || static_cast<std::size_t>(status.st_size) < bytes) {
+        ::close(descriptor);
+        throw std::runtime_error("Shared memory " + name + " is smaller than expected");
+    }
+    void *address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    ::close(descriptor);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Could not map shared memory " + name + ": " + std::strerror(errno));
+    }
+
+    SharedMemory memory;
+    memory.name = name;
+    memory.address = address;
+    memory.bytes = bytes;
+    return memory;
+}
+
+#endif
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include "headers/SharedParameters.h"
+
+using namespace neuralNet;
+
+// <-- SHARED PARAMETERS IMPLEMENTATION --> //
+
+//Values added up at a time during a reduction, small enough for the sums to stay in the L1 cache
+constexpr long reductionChunkSize = 1024;
+
+//Identifies checkpoint files, followed by the number of parameters and the step they were written at
+constexpr std::uint64_t checkpointMagic = 0x4E4E434B50543031ull;
+
+//Values of a cache line, the ranges of the workers start on one so they never write to the same line
+constexpr long valuesPerLine = tensorAlignment / sizeof(double);
+
+SharedParameters::SharedParameters(const std::string &name, int worker, int workerCount, long parameterCount,
+                                   int timeoutSeconds)
+        : workerIndex(worker), workers(workerCount), count(parameterCount), timeoutSeconds(timeoutSeconds) {
+    if (workerCount < 1 || worker < 0 || worker >= workerCount) {
+        throw std::invalid_argument("Worker " + std::to_string(worker) + " is not one of " +
+                                    std::to_string(workerCount) + " workers");
+    }
+
+    std::size_t bytes = segmentBytes(parameterCount, workerCount);
+    if (worker == 0) {
+        memory = SharedMemory::create(name, bytes);
+        locate();
+        header->magic = segmentMagic;
+        header->parameterCount = parameterCount;
+        header->workerCount = workerCount;
+        new(&header->ready) std::atomic<std::uint32_t>(0);
+        new(&header->reducedRanges) std::atomic<std::uint64_t>(0);
+        for (int slot = 0; slot < workerCount; slot++) {
+            new(&slotStates[slot].publishedStep) std::atomic<std::uint64_t>(0);
+        }
+        return;
+    }
+
+    //Worker 0 may not have created the segment yet
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSeconds);
+    while (true) {
+        try {
+            memory = SharedMemory::open(name, bytes);
+            break;
+        } catch (const std::runtime_error &) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                throw;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    locate();
+}
+
+long SharedParameters::slotSize() const {
+    return (count + valuesPerLine - 1) / valuesPerLine * valuesPerLine;
+}
+
+std::size_t SharedParameters::segmentBytes(long parameterCount, int workerCount) {
+    long slotValues = (parameterCount + valuesPerLine - 1) / valuesPerLine * valuesPerLine;
+    return tensorAlignment + workerCount * sizeof(SlotState) + (workerCount + 1) * slotValues * sizeof(double);
+}
+
+void SharedParameters::locate() {
+    static_assert(sizeof(Header) <= tensorAlignment, "The header takes a single cache line");
+    auto *base = static_cast<char *>(memory.data());
+    header = reinterpret_cast<Header *>(base);
+    slotStates = reinterpret_cast<SlotState *>(base + tensorAlignment);
+    parameterValues = reinterpret_cast<double *>(base + tensorAlignment + workers * sizeof(SlotState));
+    gradientSlots = parameterValues + slotSize();
+}
+
+template<typename Condition>
+void SharedParameters::waitUntil(Condition condition, const char *what) const {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSeconds);
+    for (long spins = 0; !condition(); spins++) {
+        std::this_thread::yield();
+        if (spins % 1024 == 0 && std::chrono::steady_clock::now() >= deadline) {
+            throw std::runtime_error(std::string("Gave up waiting for the other workers to ") + what);
+        }
+    }
+}
+
+int SharedParameters::worker() const {
+    return workerIndex;
+}
+
+int SharedParameters::workerCount() const {
+    return workers;
+}
+
+TensorView<double> SharedParameters::parameters() const {
+    return {parameterValues, count};
+}
+
+TensorView<double> SharedParameters::gradientSlot() const {
+    return {gradientSlots + workerIndex * slotSize(), count};
+}
+
+void SharedParameters::join(TensorView<const double> startingParameters) {
+    if (startingParameters.size() != count) {
+        throw std::invalid_argument("The network has " + std::to_string(startingParameters.size())
+                                    + " parameters, the shared segment " + std::to_string(count));
+    }
+
+    if (workerIndex == 0) {
+        if (!loaded) {
+            parameters().copyFrom(startingParameters);
+        }
+        header->ready.store(1, std::memory_order_release);
+        return;
+    }
+
+    waitUntil([&]() { return header->ready.load(std::memory_order_acquire) == 1; }, "start");
+    if (header->magic != segmentMagic || header->parameterCount != count || header->workerCount != workers) {
+        throw std::invalid_argument("The shared segment was made for another network or number of workers");
+    }
+}
+
+void SharedParameters::reduce(double learnRate) {
+    step++;
+    slotStates[workerIndex].publishedStep.store(step, std::memory_order_release);
+    for (int other = 0; other < workers; other++) {
+        waitUntil([&]() { return slotStates[other].publishedStep.load(std::memory_order_acquire) >= step; },
+                  "publish their gradients");
+    }
+
+    //Every worker takes a range of whole cache lines
+    long lines = slotSize() / valuesPerLine;
+    long begin = std::min(count, lines * workerIndex / workers * valuesPerLine);
+    long end = std::min(count, lines * (workerIndex + 1) / workers * valuesPerLine);
+
+    double sums[reductionChunkSize];
+    for (long chunkBegin = begin; chunkBegin < end; chunkBegin += reductionChunkSize) {
+        long chunkSize = std::min(reductionChunkSize, end - chunkBegin);
+        std::fill(sums, sums + chunkSize, 0.0);
+        for (int slot = 0; slot < workers; slot++) {
+            double *slotValues = gradientSlots + slot * slotSize() + chunkBegin;
+            for (long index = 0; index < chunkSize; index++) {
+                sums[index] += slotValues[index];
+                slotValues[index] = 0;
+            }
+        }
+
+        double *values = parameterValues + chunkBegin;
+        for (long index = 0; index < chunkSize; index++) {
+            values[index] -= sums[index] * learnRate;
+        }
+    }
+
+    header->reducedRanges.fetch_add(1, std::memory_order_acq_rel);
+    std::uint64_t target = step * static_cast<std::uint64_t>(workers);
+    waitUntil([&]() { return header->reducedRanges.load(std::memory_order_acquire) >= target; },
+              "apply their gradients");
+}
+
+void SharedParameters::writeCheckpoint(const std::string &path) const {
+    std::ofstream file(path, std::ios::binary);
+    std::int64_t parameterCount = count;
+    file.write(reinterpret_cast<const char *>(&checkpointMagic), sizeof(checkpointMagic));
+    file.write(reinterpret_cast<const char *>(&parameterCount), sizeof(parameterCount));
+    file.write(reinterpret_cast<const char *>(&step), sizeof(step));
+    file.write(reinterpret_cast<const char *>(parameterValues), static_cast<std::streamsize>(count * sizeof(double)));
+    if (!file) {
+        throw std::runtime_error("Could not write the checkpoint " + path);
+    }
+}
+
+void SharedParameters::readCheckpoint(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    std::uint64_t magic = 0;
+    std::int64_t parameterCount = 0;
+    std::uint64_t checkpointStep = 0;
+    file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char *>(&parameterCount), sizeof(parameterCount));
+    file.read(reinterpret_cast<char *>(&checkpointStep), sizeof(checkpointStep));
+    if (!file || magic != checkpointMagic || parameterCount != count) {
+        throw std::runtime_error("The checkpoint " + path + " does not hold the parameters of this network");
+    }
+
+    file.read(reinterpret_cast<char *>(parameterValues), static_cast<std::streamsize>(count * sizeof(double)));
+    if (!file) {
+        throw std::runtime_error("The checkpoint " + path + " is cut short");
+    }
+    loaded = true;
+}
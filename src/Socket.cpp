@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "headers/Socket.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace neuralNet;
+
+// <-- PLATFORM HELPERS --> //
+
+#ifdef _WIN32
+using PollDescriptor = WSAPOLLFD;
+
+//Winsock has to be started once before any socket is made
+void startNetworking() {
+    static bool started = []() {
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+            throw std::runtime_error("Could not start winsock");
+        }
+        return true;
+    }();
+    (void) started;
+}
+
+int lastError() {
+    return WSAGetLastError();
+}
+
+bool wouldBlock(int error) {
+    return error == WSAEWOULDBLOCK || error == WSAEINTR;
+}
+
+bool connectionRefused(int error) {
+    return error == WSAECONNREFUSED || error == WSAETIMEDOUT;
+}
+
+void closeHandle(Socket::Handle handle) {
+    closesocket(handle);
+}
+
+void setNonBlocking(Socket::Handle handle) {
+    u_long enabled = 1;
+    ioctlsocket(handle, FIONBIO, &enabled);
+}
+
+int pollSockets(PollDescriptor *descriptors, int count, int timeoutMilliseconds) {
+    return WSAPoll(descriptors, count, timeoutMilliseconds);
+}
+
+//Windows never raises a signal for a closed connection
+constexpr int sendFlags = 0;
+#else
+using PollDescriptor = pollfd;
+
+void startNetworking() {}
+
+int lastError() {
+    return errno;
+}
+
+bool wouldBlock(int error) {
+    return error == EAGAIN || error == EWOULDBLOCK || error == EINTR;
+}
+
+bool connectionRefused(int error) {
+    return error == ECONNREFUSED || error == ETIMEDOUT;
+}
+
+void closeHandle(Socket::Handle handle) {
+    ::close(handle);
+}
+
+void setNonBlocking(Socket::Handle handle) {
+    fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK);
+}
+
+int pollSockets(PollDescriptor *descriptors, int count, int timeoutMilliseconds) {
+    return poll(descriptors, count, timeoutMilliseconds);
+}
+
+//A peer closing its end must show up as an error, not kill the process with SIGPIPE
+#ifdef MSG_NOSIGNAL
+constexpr int sendFlags = MSG_NOSIGNAL;
+#else
+constexpr int sendFlags = 0;
+#endif
+#endif
+
+//Largest piece a single send or receive moves, the calls taking an int on Windows
+constexpr std::size_t maxTransferBytes = 1 << 30;
+
+[[noreturn]] void throwSocketError(const std::string &what) {
+    throw std::runtime_error(what + " (error " + std::to_string(lastError()) + ")");
+}
+
+//Makes a connected socket non-blocking, and sends small messages right away rather than waiting for more
+void configureConnection(Socket::Handle handle) {
+    setNonBlocking(handle);
+    int enabled = 1;
+    setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&enabled), sizeof(enabled));
+}
+
+// <-- SOCKET IMPLEMENTATION --> //
+
+Socket::Socket(Handle handle) : handle(handle) {}
+
+Socket::Socket(Socket &&other) noexcept: handle(other.handle) {
+    other.handle = invalidHandle;
+}
+
+Socket &Socket::operator=(Socket &&other) noexcept {
+    if (this != &other) {
+        close();
+        handle = other.handle;
+        other.handle = invalidHandle;
+    }
+    return *this;
+}
+
+Socket::~Socket() {
+    close();
+}
+
+Socket Socket::listen(std::uint16_t port) {
+    startNetworking();
+    Socket listener(::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+    if (!listener.isOpen()) {
+        throwSocketError("Could not create a socket");
+    }
+
+    //A process started again right after the previous one stopped can use the same port
+    int enabled = 1;
+    setsockopt(listener.handle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&enabled), sizeof(enabled));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(listener.handle, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        throwSocketError("Could not bind port " + std::to_string(port));
+    }
+    if (::listen(listener.handle, 8) != 0) {
+        throwSocketError("Could not listen on port " + std::to_string(port));
+    }
+    setNonBlocking(listener.handle);
+    return listener;
+}
+
+Socket Socket::connect(const std::string &host, std::uint16_t port, int timeoutSeconds) {
+    startNetworking();
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addresses = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0 || addresses == nullptr) {
+        throw std::runtime_error("Could not resolve " + host);
+    }
+
+    //The peer may not listen yet, so refused connections are tried again until the deadline
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSeconds);
+    while (true) {
+        Socket connection(::socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol));
+        if (!connection.isOpen()) {
+            freeaddrinfo(addresses);
+            throwSocketError("Could not create a socket");
+        }
+        if (::connect(connection.handle, addresses->ai_addr, static_cast<int>(addresses->ai_addrlen)) == 0) {
+            freeaddrinfo(addresses);
+            configureConnection(connection.handle);
+            return connection;
+        }
+
+        int error = lastError();
+        if (!connectionRefused(error) || std::chrono::steady_clock::now() >= deadline) {
+            freeaddrinfo(addresses);
+            throw std::runtime_error("Could not connect to " + host + ":" + std::to_string(port) + " (error "
+                                     + std::to_string(error) + ")");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+Socket Socket::accept(int timeoutSeconds) {
+    PollDescriptor descriptor{};
+    descriptor.fd = handle;
+    descriptor.events = POLLIN;
+    int ready = pollSockets(&descriptor, 1, timeoutSeconds * 1000);
+    if (ready < 0) {
+        throwSocketError("Could not wait for a connection");
+    }
+    if (ready == 0) {
+        throw std::runtime_error("No connection came within " + std::to_string(timeoutSeconds) + " seconds");
+    }
+
+    Socket connection(::accept(handle, nullptr, nullptr));
+    if (!connection.isOpen()) {
+        throwSocketError("Could not accept a connection");
+    }
+    configureConnection(connection.handle);
+    return connection;
+}
+
+bool Socket::isOpen() const {
+    return handle != invalidHandle;
+}
+
+void Socket::close() {
+    if (isOpen()) {
+        closeHandle(handle);
+        handle = invalidHandle;
+    }
+}
+
+void Socket::sendAll(const void *data, std::size_t bytes) {
+    exchange(*this, data, bytes, *this, nullptr, 0);
+}
+
+void Socket::receiveAll(void *data, std::size_t bytes) {
+    exchange(*this, nullptr, 0, *this, data, bytes);
+}
+
+void Socket::exchange(Socket &sendSocket, const void *sendData, std::size_t sendBytes,
+                      Socket &receiveSocket, void *receiveData, std::size_t receiveBytes) {
+    const char *sendPosition = static_cast<const char *>(sendData);
+    char *receivePosition = static_cast<char *>(receiveData);
+    std::size_t sent = 0;
+    std::size_t received = 0;
+
+    //Wait until one of the sockets can make progress, and move as much as it takes without blocking
+    while (sent < sendBytes || received < receiveBytes) {
+        PollDescriptor descriptors[2]{};
+        int count = 0;
+        if (sent < sendBytes) {
+            descriptors[count].fd = sendSocket.handle;
+            descriptors[count++].events = POLLOUT;
+        }
+        if (received < receiveBytes) {
+            descriptors[count].fd = receiveSocket.handle;
+            descriptors[count++].events = POLLIN;
+        }
+        if (pollSockets(descriptors, count, -1) < 0) {
+            if (wouldBlock(lastError())) {
+                continue;
+            }
+            throwSocketError("Could not wait on the connections");
+        }
+
+        for (int index = 0; index < count; index++) {
+            if (descriptors[index].revents == 0) {
+                continue;
+            }
+            if (descriptors[index].events == POLLOUT) {
+                auto result = ::send(sendSocket.handle, sendPosition + sent,
+                                     static_cast<int>(std::min(sendBytes - sent, maxTransferBytes)), sendFlags);
+                if (result < 0 && !wouldBlock(lastError())) {
+                    throwSocketError("Could not send to a peer");
+                }
+                sent += result > 0 ? static_cast<std::size_t>(result) : 0;
+            } else {
+                auto result = ::recv(receiveSocket.handle, receivePosition + received,
+                                     static_cast<int>(std::min(receiveBytes - received, maxTransferBytes)), 0);
+                if (result == 0) {
+                    throw std::runtime_error("A peer closed its connection");
+                }
+                if (result < 0 && !wouldBlock(lastError())) {
+                    throwSocketError("Could not receive from a peer");
+                }
+                received += result > 0 ? static_cast<std::size_t>(result) : 0;
+            }
+        }
+    }
+}
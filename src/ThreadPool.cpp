@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "headers/ThreadPool.h"
+
+using namespace neuralNet;
+
+// <-- THREAD POOL IMPLEMENTATION --> //
+
+//Set on the threads running a task, so a job started from inside a task does not wait on itself
+thread_local bool insideTask = false;
+
+ThreadPool::ThreadPool(int threadCount) {
+    for (int index = 1; index < threadCount; index++) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    jobStarted.notify_all();
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+int ThreadPool::threadCount() const {
+    return static_cast<int>(workers.size()) + 1;
+}
+
+long ThreadPool::runTasks() {
+    bool wasInsideTask = insideTask;
+    insideTask = true;
+
+    long ran = 0;
+    for (long index = nextTask++; index < taskCount; index = nextTask++) {
+        try {
+            (*task)(index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        ran++;
+    }
+    insideTask = wasInsideTask;
+    return ran;
+}
+
+void ThreadPool::workerLoop() {
+    unsigned long lastJob = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            jobStarted.wait(lock, [&]() { return stopping || jobNumber != lastJob; });
+            if (stopping) {
+                return;
+            }
+            lastJob = jobNumber;
+            activeWorkers++;
+        }
+
+        long ran = runTasks();
+
+        std::lock_guard<std::mutex> lock(stateMutex);
+        finishedTasks += ran;
+        activeWorkers--;
+        if (finishedTasks == taskCount && activeWorkers == 0) {
+            jobFinished.notify_all();
+        }
+    }
+}
+
+void ThreadPool::run(long count, const std::function<void(long)> &task) {
+    if (count <= 0) {
+        return;
+    }
+
+    //Nothing to share the work with, or already on a thread of the pool: just loop
+    if (workers.empty() || count == 1 || insideTask) {
+        for (long index = 0; index < count; index++) {
+            task(index);
+        }
+        return;
+    }
+    runJob(count, task);
+}
+
+void ThreadPool::runConcurrently(long count, const std::function<void(long)> &task) {
+    if (count > threadCount()) {
+        throw std::logic_error("Running " + std::to_string(count) + " tasks at once needs as many threads, the pool "
+                               "has " + std::to_string(threadCount()));
+    }
+    if (count > 0) {
+        runJob(count, task);
+    }
+}
+
+void ThreadPool::runJob(long count, const std::function<void(long)> &task) {
+    std::lock_guard<std::mutex> jobLock(jobMutex);
+    {
+        //A worker that woke up too late for the last job may still be on its way out
+        std::unique_lock<std::mutex> lock(stateMutex);
+        jobFinished.wait(lock, [&]() { return activeWorkers == 0; });
+        this->task = &task;
+        taskCount = count;
+        nextTask = 0;
+        finishedTasks = 0;
+        error = nullptr;
+        jobNumber++;
+    }
+    jobStarted.notify_all();
+
+    long ran = runTasks();
+
+    std::exception_ptr jobError;
+    {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        finishedTasks += ran;
+        jobFinished.wait(lock, [&]() { return finishedTasks == taskCount && activeWorkers == 0; });
+        this->task = nullptr;
+        jobError = error;
+    }
+    if (jobError) {
+        std::rethrow_exception(jobError);
+    }
+}
+
+void ThreadPool::parallelFor(long begin, long end, long chunkSize, const std::function<void(long, long)> &body) {
+    chunkSize = std::max(chunkSize, 1L);
+    long chunks = (end - begin + chunkSize - 1) / chunkSize;
+    run(chunks, [&](long chunk) {
+        long chunkBegin = begin + chunk * chunkSize;
+        body(chunkBegin, std::min(end, chunkBegin + chunkSize));
+    });
+}
+
+ThreadPool &ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
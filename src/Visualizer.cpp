@@ -0,0 +1,224 @@
+#include "headers/Visualizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <variant>
+
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
+// <-- HELPER FUNCTIONS --> //
+
+//Writes a weight as a color: red for positive weights, blue for negative ones, black around 0
+void writeWeightColor(unsigned char *pixel, double weight, double maxMagnitude) {
+    double value = maxMagnitude > 0 ? std::min(std::abs(weight) / maxMagnitude, 1.0) : 0;
+    auto intensity = static_cast<unsigned char>(value * 255.0);
+    pixel[0] = weight > 0 ? intensity : 0;
+    pixel[1] = static_cast<unsigned char>(intensity / 4);
+    pixel[2] = weight > 0 ? 0 : intensity;
+    pixel[3] = 255;
+}
+
+//Writes an activation between 0 and 1 as a shade of gray
+void writeActivationColor(unsigned char *pixel, double activation) {
+    auto intensity = static_cast<unsigned char>(std::clamp(activation, 0.0, 1.0) * 255.0);
+    pixel[0] = intensity;
+    pixel[1] = intensity;
+    pixel[2] = intensity;
+    pixel[3] = 255;
+}
+
+//Picks the most square-like width for showing a number of nodes as an image
+int squareWidth(int nodes) {
+    return std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(nodes)))));
+}
+
+// <-- TEXTURE HELPERS --> //
+
+GLuint createImageTexture(int width, int height) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    //Allocate the storage once, after this the texture is only ever updated with glTexSubImage2D
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    return texture;
+}
+
+void uploadImageTexture(GLuint texture, int width, int height, const unsigned char *pixels) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+}
+
+ImTextureID toImTexture(GLuint texture) {
+    return reinterpret_cast<ImTextureID>(static_cast<intptr_t>(texture));
+}
+
+// <-- NETWORK VISUALIZER IMPLEMENTATION --> //
+
+void NetworkVisualizer::attach(neuralNet::NeuralNetwork *network, const neuralNet::Dataset *dataset) {
+    release();
+    this->network = network;
+    this->dataset = dataset;
+    selectedSample = 0;
+}
+
+void NetworkVisualizer::createTextures() {
+    //Show the first layer that has weights, a dense layer or a convolution
+    weightsLayer = 0;
+    while (weightsLayer < network->layerCount()
+           && !std::holds_alternative<neuralNet::DenseLayer>(network->layer(weightsLayer))
+           && !std::holds_alternative<neuralNet::Conv2DLayer>(network->layer(weightsLayer))) {
+        weightsLayer++;
+    }
+
+    //Each tile has a pixel per input, so 784 inputs become 28x28 tiles
+    int nodesIn = 1;
+    int nodesOut = 1;
+    if (weightsLayer < network->layerCount()) {
+        network->copyLayerParameters(weightsLayer, weights, biases);
+        nodesIn = static_cast<int>(weights.dim(0));
+        nodesOut = static_cast<int>(weights.dim(1));
+    }
+    tileWidth = squareWidth(nodesIn);
+    tileHeight = (nodesIn + tileWidth - 1) / tileWidth;
+    tilesPerRow = squareWidth(nodesOut);
+
+    //Leave a 1 pixel gap between the tiles
+    atlasWidth = tilesPerRow * (tileWidth + 1);
+    atlasHeight = ((nodesOut + tilesPerRow - 1) / tilesPerRow) * (tileHeight + 1);
+    weightsTexture = createImageTexture(atlasWidth, atlasHeight);
+
+    //Every layer (the input layer included) is shown as a square, so 784 inputs are shown as 28x28 like the tiles
+    activationWidths.clear();
+    activationHeights.clear();
+    for (long nodes: network->activationSizes()) {
+        activationWidths.push_back(squareWidth(static_cast<int>(nodes)));
+        activationHeights.push_back(static_cast<int>((nodes + activationWidths.back() - 1) / activationWidths.back()));
+    }
+
+    for (int layer = 0; layer < activationWidths.size(); layer++) {
+        activationTextures.push_back(createImageTexture(activationWidths[layer], activationHeights[layer]));
+    }
+}
+
+void NetworkVisualizer::uploadWeights() {
+    if (weightsLayer == network->layerCount()) {
+        uploadedVersion = network->version();
+        return;
+    }
+    uploadedVersion = network->copyLayerParameters(weightsLayer, weights, biases);
+    int nodesIn = static_cast<int>(weights.dim(0));
+    int nodesOut = static_cast<int>(weights.dim(1));
+
+    double maxMagnitude = 0;
+    for (auto &weight: weights) {
+        maxMagnitude = std::max(maxMagnitude, std::abs(weight));
+    }
+
+    //Start from a black atlas, so the gaps and unused tiles stay black
+    pixels.assign(static_cast<size_t>(atlasWidth) * atlasHeight * 4, 0);
+
+    for (int nodeOut = 0; nodeOut < nodesOut; nodeOut++) {
+        int tileX = (nodeOut % tilesPerRow) * (tileWidth + 1);
+        int tileY = (nodeOut / tilesPerRow) * (tileHeight + 1);
+
+        for (int nodeIn = 0; nodeIn < nodesIn; nodeIn++) {
+            int x = tileX + nodeIn % tileWidth;
+            int y = tileY + nodeIn / tileWidth;
+            writeWeightColor(&pixels[(static_cast<size_t>(y) * atlasWidth + x) * 4], weights(nodeIn, nodeOut),
+                             maxMagnitude);
+        }
+    }
+
+    uploadImageTexture(weightsTexture, atlasWidth, atlasHeight, pixels.data());
+}
+
+void NetworkVisualizer::uploadActivations() {
+    uploadedSample = selectedSample;
+    dataset->loadBatch(selectedSample, 1, sampleBatch);
+    std::vector<neuralNet::Tensor<double>> activations = network->layerActivations(sampleBatch.inputs.row(0));
+
+    for (int layer = 0; layer < activations.size(); layer++) {
+        int width = activationWidths[layer];
+        int height = activationHeights[layer];
+        pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+
+        for (int node = 0; node < activations[layer].size(); node++) {
+            writeActivationColor(&pixels[static_cast<size_t>(node) * 4], activations[layer][node]);
+        }
+
+        uploadImageTexture(activationTextures[layer], width, height, pixels.data());
+    }
+}
+
+void NetworkVisualizer::draw() {
+    if (network == nullptr) {
+        return;
+    }
+
+    if (weightsTexture == 0) {
+        createTextures();
+    }
+
+    //Only go back to the network when something changed, and not more often than uploadInterval
+    double now = glfwGetTime();
+    if (lastUploadTime < 0 || now - lastUploadTime >= uploadInterval) {
+        bool weightsChanged = lastUploadTime < 0 || network->version() != uploadedVersion;
+        if (weightsChanged) {
+            uploadWeights();
+        }
+        if (dataset != nullptr && dataset->size() > 0
+            && (weightsChanged || selectedSample != uploadedSample)) {
+            uploadActivations();
+        }
+        lastUploadTime = now;
+    }
+
+    if (ImGui::Begin("Network")) {
+        ImGui::Text("Parameters version: %lu", uploadedVersion);
+        ImGui::SliderFloat("Upload interval (s)", &uploadInterval, 0.0f, 2.0f);
+
+        //Scale the atlas to the width of the window
+        ImGui::SeparatorText("Weights");
+        float scale = std::max(1.0f, ImGui::GetContentRegionAvail().x / atlasWidth);
+        ImGui::Image(toImTexture(weightsTexture), ImVec2(atlasWidth * scale, atlasHeight * scale));
+
+        if (dataset != nullptr && dataset->size() > 0) {
+            ImGui::SeparatorText("Activations");
+            ImGui::SliderInt("Sample", &selectedSample, 0, dataset->size() - 1);
+            ImGui::SameLine();
+            ImGui::Text("Label: %d", dataset->label(selectedSample));
+
+            for (int layer = 0; layer < activationTextures.size(); layer++) {
+                if (layer > 0) {
+                    ImGui::SameLine();
+                }
+                float height = 112.0f;
+                float width = height * activationWidths[layer] / activationHeights[layer];
+                ImGui::Image(toImTexture(activationTextures[layer]), ImVec2(width, height));
+            }
+        }
+    }
+    ImGui::End();
+}
+
+void NetworkVisualizer::release() {
+    if (weightsTexture != 0) {
+        glDeleteTextures(1, &weightsTexture);
+        weightsTexture = 0;
+    }
+    if (!activationTextures.empty()) {
+        glDeleteTextures(static_cast<GLsizei>(activationTextures.size()), activationTextures.data());
+        activationTextures.clear();
+    }
+    activationWidths.clear();
+    activationHeights.clear();
+    lastUploadTime = -1;
+    uploadedSample = -1;
+}
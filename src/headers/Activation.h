@@ -0,0 +1,86 @@
+#ifndef NEURALNETWORK_ACTIVATION_H
+#define NEURALNETWORK_ACTIVATION_H
+
+#include <algorithm>
+#include <cmath>
+
+namespace neuralNet {
+    enum class ActivationFunction {
+        Linear, Sigmoid, ReLU, Tanh
+    };
+
+    //Applies a sigmoid function to the weighted input of a node
+    inline double sigmoid(double input) {
+        return 1.0 / (1.0 + std::exp(-input));
+    }
+
+    /* Calculates the derivative of the sigmoid function with respect to the weighted input,
+       from the activation value the sigmoid returned */
+    inline double sigmoidDerivative(double activation) {
+        return activation * (1 - activation);
+    }
+
+    /* Applies the activation function to count weighted inputs, in place. The function is picked once for the whole
+       array rather than once per value, so each loop only does the math of a single function */
+    inline void applyActivation(ActivationFunction function, double *values, long count) {
+        switch (function) {
+            case ActivationFunction::Linear:
+                break;
+            case ActivationFunction::Sigmoid:
+                for (long index = 0; index < count; index++) {
+                    values[index] = sigmoid(values[index]);
+                }
+                break;
+            case ActivationFunction::ReLU:
+                for (long index = 0; index < count; index++) {
+                    values[index] = std::max(values[index], 0.0);
+                }
+                break;
+            case ActivationFunction::Tanh:
+                for (long index = 0; index < count; index++) {
+                    values[index] = std::tanh(values[index]);
+                }
+                break;
+        }
+    }
+
+    /* Multiplies the derivatives of the cost with respect to count activations by the derivatives of the activations
+       with respect to their weighted inputs. Every derivative is calculated from the activation value, so the
+       weighted inputs never have to be kept */
+    inline void multiplyActivationDerivative(ActivationFunction function, const double *activations,
+                                             const double *gradients, double *products, long count) {
+        switch (function) {
+            case ActivationFunction::Linear:
+                std::copy(gradients, gradients + count, products);
+                break;
+            case ActivationFunction::Sigmoid:
+                for (long index = 0; index < count; index++) {
+                    products[index] = gradients[index] * sigmoidDerivative(activations[index]);
+                }
+                break;
+            case ActivationFunction::ReLU:
+                for (long index = 0; index < count; index++) {
+                    products[index] = activations[index] > 0 ? gradients[index] : 0.0;
+                }
+                break;
+            case ActivationFunction::Tanh:
+                for (long index = 0; index < count; index++) {
+                    products[index] = gradients[index] * (1 - activations[index] * activations[index]);
+                }
+                break;
+        }
+    }
+
+    //Calculates the cost of a node
+    inline double squaredError(double outputActivation, double expectedOutput) {
+        double error = outputActivation - expectedOutput;
+        return error * error;
+    }
+
+    //Calculates the derivative of the cost, with respect to the activation value
+    inline double squaredErrorDerivative(double outputActivation, double expectedOutput) {
+        return 2 * (outputActivation - expectedOutput);
+    }
+}
+
+#endif //NEURALNETWORK_ACTIVATION_H
@@ -0,0 +1,49 @@
+#ifndef NEURALNETWORK_ACTIVATIONLAYER_H
+#define NEURALNETWORK_ACTIVATIONLAYER_H
+
+#include <cstdint>
+#include "Tensor.h"
+#include "Arena.h"
+#include "Activation.h"
+#include "ImageShape.h"
+
+namespace neuralNet {
+    /* Applies an activation function to every value on its own, keeping the shape. Lets a layer with a linear
+       activation be followed by something else (like a normalization) before its non linearity */
+    class ActivationLayer {
+    private:
+        ActivationFunction activation = ActivationFunction::Sigmoid;
+        ImageShape shape;
+
+        TensorView<double> activations;
+
+    public:
+        ActivationLayer() = default;
+
+        ActivationLayer(ActivationFunction activation, ImageShape shape);
+
+        const ImageShape &getOutputShape() const;
+
+        ActivationFunction getActivationFunction() const;
+
+        long parameterCount() const;
+
+        void bindParameters(TensorView<double> parameters, TensorView<double> gradients);
+
+        void initializeParameters(std::uint64_t seed);
+
+        std::size_t workspaceBytes(long batchSize) const;
+
+        TensorView<const double> getActivations() const;
+
+        void computeActivations(TensorView<const double> inputs, TensorView<double> outputs, Arena &arena) const;
+
+        void calculateOutputs(TensorView<const double> inputs, Arena &arena);
+
+        //Multiplies the derivatives of the cost by the derivative of the activation function
+        TensorView<const double> backPropagate(TensorView<const double> outputGradients, Arena &arena,
+                                               bool needInputGradients);
+    };
+}
+
+#endif //NEURALNETWORK_ACTIVATIONLAYER_H
@@ -0,0 +1,78 @@
+#ifndef NEURALNETWORK_ARENA_H
+#define NEURALNETWORK_ARENA_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+#include "Tensor.h"
+
+namespace neuralNet {
+    /* Bump allocator for scratch buffers that only live for one step of training (gradient products,
+       temporary activations...). Allocating just moves an offset forward, and everything is freed at
+       once by reset(). When a step needs more memory than the arena has, an extra block is added, and
+       the next reset() merges all the blocks into one big enough for the whole step. After the first
+       step, allocating never has to go to malloc again. An arena is meant to be owned by a single
+       training context, so it is not thread safe and there is no lock to fight over */
+    class Arena {
+    private:
+        struct AlignedDeleter {
+            void operator()(std::byte *block) const {
+                ::operator delete(block, std::align_val_t(tensorAlignment));
+            }
+        };
+
+        struct Block {
+            std::unique_ptr<std::byte, AlignedDeleter> memory;
+            std::size_t size;
+        };
+
+        std::vector<Block> blocks;
+
+        //Block currently being allocated from, and how much of it is already handed out
+        std::size_t currentBlock = 0;
+        std::size_t offset = 0;
+
+        //Bytes handed out since the last reset, over all the blocks
+        std::size_t usedBytes = 0;
+
+        //Adds a block with room for at least the given number of bytes
+        void addBlock(std::size_t minimumSize);
+
+    public:
+        explicit Arena(std::size_t initialCapacity = 64 * 1024);
+
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+        Arena(Arena &&) noexcept = default;
+        Arena &operator=(Arena &&) noexcept = default;
+
+        //Returns uninitialized memory aligned to the given number of bytes, valid until the next reset
+        void *allocateBytes(std::size_t bytes, std::size_t alignment = tensorAlignment);
+
+        //Returns an uninitialized tensor view with the given shape, valid until the next reset
+        template<typename T>
+        TensorView<T> allocate(std::initializer_list<long> shape) {
+            TensorView<T> shaped(nullptr, shape);
+            return TensorView<T>(static_cast<T *>(allocateBytes(shaped.size() * sizeof(T))), shape);
+        }
+
+        /* Returns the number of bytes allocating count values of type T takes out of the arena, alignment included,
+           so layers can tell up front how much scratch memory a step will need */
+        template<typename T>
+        static std::size_t bytesFor(long count) {
+            return (count * sizeof(T) + tensorAlignment - 1) / tensorAlignment * tensorAlignment;
+        }
+
+        //Frees everything that was allocated, keeping the memory around for the next step
+        void reset();
+
+        //Returns the number of bytes handed out since the last reset
+        std::size_t used() const;
+
+        //Returns the number of bytes the arena owns
+        std::size_t capacity() const;
+    };
+}
+
+#endif //NEURALNETWORK_ARENA_H
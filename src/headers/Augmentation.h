@@ -0,0 +1,87 @@
+#ifndef NEURALNETWORK_AUGMENTATION_H
+#define NEURALNETWORK_AUGMENTATION_H
+
+#include <cstdint>
+#include <vector>
+#include "ImageShape.h"
+#include "Random.h"
+
+namespace neuralNet {
+    //How far the random transformations of an augmentation go, a setting of 0 turning its transformation off
+    struct AugmentationSettings {
+        //Largest shift in pixels, either way along both axes
+        double maxShift = 2;
+
+        //Largest rotation in radians, either way
+        double maxRotation = 0.15;
+
+        //Range the zoom factor is drawn from
+        double minScale = 0.9;
+        double maxScale = 1.1;
+
+        /* Elastic distortion (Simard et al., "Best practices for convolutional neural networks applied to visual
+           document analysis"): a random displacement per pixel, smoothed by a gaussian of elasticSigma pixels and
+           multiplied by elasticAlpha */
+        double elasticAlpha = 0;
+        double elasticSigma = 4;
+
+        //Deviation of the gaussian noise added to every input, after scaling
+        double noise = 0;
+    };
+
+    /* Turns the raw images of a dataset into randomly shifted, rotated, zoomed, distorted and noisy ones while they
+       are converted to the inputs of a batch, resampling them bilinearly (pixels outside the image are 0). Every
+       channel of an image gets the same transformation. The random numbers come from Philox with the number of the
+       sample in the key, so a sample is transformed the same way whatever thread handles it. The padded copy of
+       the image spares the resampling any bounds checks, and only gathering the scattered corners of the pixels
+       is scalar: every other loop works on whole arrays of pixels without branches, so the compiler vectorizes it */
+    class Augmentation {
+    public:
+        //Scratch memory of one thread, sized on first use
+        struct Workspace {
+            //The scaled image with a border of zeros, so resampling never has to check the bounds
+            std::vector<double> padded;
+
+            //Where every output pixel is taken from in the image, then only the fractions of these positions
+            std::vector<double> sourceX;
+            std::vector<double> sourceY;
+
+            //Index of the top left corner of every output pixel in the padded image
+            std::vector<int> cornerIndices;
+
+            //Values of the four corners of every output pixel, gathered one array after the other
+            std::vector<double> corners;
+
+            //Elastic displacements, and the half smoothed ones
+            std::vector<double> fieldX;
+            std::vector<double> fieldY;
+            std::vector<double> smoothing;
+
+            std::vector<double> noise;
+        };
+
+    private:
+        ImageShape shape;
+        AugmentationSettings settings;
+        std::uint64_t seed = 0;
+
+        //Weights of the gaussian smoothing the elastic displacements, from -radius to radius
+        std::vector<double> smoothingKernel;
+
+        //Draws the displacements of a sample, smoothed and scaled, into the fields of the workspace
+        void elasticField(Philox::Key sampleKey, Workspace &workspace) const;
+
+    public:
+        //Throws std::invalid_argument for settings that make no sense, like a negative shift or a scale of 0
+        Augmentation(ImageShape shape, AugmentationSettings settings = {}, std::uint64_t seed = randomSeed());
+
+        const ImageShape &getShape() const;
+
+        /* Writes a random transformation of the image, multiplied by inputScale, to target. The same sample number
+           always gives the same transformation */
+        void apply(const std::uint8_t *image, double *target, double inputScale, std::uint64_t sample,
+                   Workspace &workspace) const;
+    };
+}
+
+#endif //NEURALNETWORK_AUGMENTATION_H
@@ -0,0 +1,108 @@
+#ifndef NEURALNETWORK_BATCHLOADER_H
+#define NEURALNETWORK_BATCHLOADER_H
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <variant>
+#include <vector>
+#include "Augmentation.h"
+#include "BoundedQueue.h"
+#include "Dataset.h"
+#include "ShardedDataset.h"
+
+namespace neuralNet {
+    //Batches a loader prepares ahead of the one the training works on
+    constexpr int defaultPrefetchBatches = 4;
+
+    //Fills the indices of the samples of the next batch, returns false once there are no batches left
+    using IndexSampler = std::function<bool(std::vector<int> &indices)>;
+
+    //Where a loader reads its samples from, in memory or in the shards of a sharded dataset
+    using SampleSource = std::variant<const Dataset *, const ShardedDataset *>;
+
+    /* Prepares batches on background threads while the network trains on the previous ones, so the training never
+       waits for its inputs. A sampling thread picks the samples of every batch (reading), and packing threads
+       convert them (uint8 inputs to scaled doubles, labels to one-hot outputs) into the batch, handed over through a
+       bounded queue, augmenting the inputs on the way when an augmentation is given. Batches are built in a fixed
+       ring of buffers that are reused, so once each of them has its shape loading allocates nothing. They come out
+       in the order they were sampled, whatever thread packed them. The sampler is only ever called from the
+       sampling thread, so it needs no locking */
+    class BatchLoader {
+    private:
+        enum class SlotState {
+            Free, Packing, Ready
+        };
+
+        //A batch buffer, batch n of the run goes to the slot n % slots.size()
+        struct Slot {
+            std::vector<int> indices;
+
+            //Number of the first sample of the batch since the start, which picks the augmentations
+            long firstSample = 0;
+            Batch batch;
+            SlotState state = SlotState::Free;
+        };
+
+        SampleSource source;
+        IndexSampler sampler;
+        const Augmentation *augmentation;
+        std::vector<Slot> slots;
+
+        //Numbers of the sampled batches waiting for a packing thread
+        BoundedQueue<long> sampledBatches;
+
+        std::thread samplingThread;
+        std::vector<std::thread> packingThreads;
+
+        std::mutex stateMutex;
+        std::condition_variable slotChanged;
+
+        //Number of the batch next hands out, the one before it stays with the caller until then
+        long nextBatch = 0;
+
+        //Number of batches the sampler gave before running out, -1 while it has not
+        long batchCount = -1;
+        bool stopping = false;
+
+        //First error of a background thread, rethrown by next
+        std::exception_ptr error;
+
+        void sampleLoop();
+
+        void packLoop();
+
+        //Records the error currently being handled and stops the background threads
+        void fail();
+
+        BatchLoader(SampleSource source, IndexSampler sampler, int packingThreads, int prefetch,
+                    const Augmentation *augmentation);
+
+    public:
+        /* Starts loading the batches the sampler picks from the dataset, which must outlive the loader, with up to
+           prefetch batches ready or being packed at once. The augmentation, when there is one, must outlive the
+           loader too, and have the shape of the samples */
+        BatchLoader(const Dataset &dataset, IndexSampler sampler, int packingThreads = 1,
+                    int prefetch = defaultPrefetchBatches, const Augmentation *augmentation = nullptr);
+
+        //Same, reading the samples from the shards of a sharded dataset, every packing thread reading its own
+        BatchLoader(const ShardedDataset &dataset, IndexSampler sampler, int packingThreads = 1,
+                    int prefetch = defaultPrefetchBatches, const Augmentation *augmentation = nullptr);
+
+        BatchLoader(const BatchLoader &) = delete;
+        BatchLoader &operator=(const BatchLoader &) = delete;
+
+        ~BatchLoader();
+
+        /* Hands the previous batch back and waits for the next one, which stays valid until the next call. Returns
+           nullptr once the sampler ran out, and rethrows the first error of the background threads */
+        const Batch *next();
+
+        //Stops the background threads, dropping the batches not handed out yet
+        void stop();
+    };
+}
+
+#endif //NEURALNETWORK_BATCHLOADER_H
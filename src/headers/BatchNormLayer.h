@@ -0,0 +1,99 @@
+#ifndef NEURALNETWORK_BATCHNORMLAYER_H
+#define NEURALNETWORK_BATCHNORMLAYER_H
+
+#include <cstdint>
+#include <vector>
+#include "Tensor.h"
+#include "Arena.h"
+#include "ImageShape.h"
+
+namespace neuralNet {
+    //How much of the running statistics is kept at every batch, the rest coming from the batch
+    constexpr double batchNormMomentum = 0.9;
+
+    //Added to the variances so features that never change do not divide by 0
+    constexpr double batchNormEpsilon = 1e-5;
+
+    /* Batch normalization: during training, every feature is shifted and scaled to a mean of 0 and a variance of 1
+       over the batch, then multiplied by a learned gamma and added a learned beta. The features are the channels of
+       images (normalized over the batch and all their pixels) or the values of plain vectors (shaped {1, 1, size}).
+       Inference uses running averages of the batch statistics instead, which makes the layer a fixed scale and shift
+       of every feature. NeuralNetwork::foldBatchNorm merges that into the layer before it, after which this layer
+       hands the values over untouched */
+    class BatchNormLayer {
+    private:
+        ImageShape shape;
+
+        //Number of features and number of values of each feature in a sample
+        int features = 1;
+        long pixels = 1;
+
+        //Learned scale and shift of every feature, and their cost gradients
+        TensorView<double> gammas;
+        TensorView<double> betas;
+        TensorView<double> costGradientGamma;
+        TensorView<double> costGradientBeta;
+
+        //Averages of the means and variances of the training batches, used for inference
+        Tensor<double> runningMeans;
+        Tensor<double> runningVariances;
+
+        //Set once the normalization has been merged into the layer before it
+        bool folded = false;
+
+        //Outputs of the last batch, or its inputs once folded
+        TensorView<const double> activations;
+
+        //The values of the last batch after normalization, before gamma and beta, and 1 / deviation of every feature
+        TensorView<double> normalized;
+        TensorView<double> inverseDeviations;
+
+    public:
+        BatchNormLayer() = default;
+
+        explicit BatchNormLayer(ImageShape shape);
+
+        const ImageShape &getOutputShape() const;
+
+        int featureCount() const;
+
+        long parameterCount() const;
+
+        void bindParameters(TensorView<double> parameters, TensorView<double> gradients);
+
+        //Starts as the identity: gammas of 1, betas of 0, running means of 0 and running variances of 1
+        void initializeParameters(std::uint64_t seed);
+
+        std::size_t workspaceBytes(long batchSize) const;
+
+        TensorView<const double> getActivations() const;
+
+        //Normalizes with the running statistics
+        void computeActivations(TensorView<const double> inputs, TensorView<double> outputs, Arena &arena) const;
+
+        //Normalizes with the statistics of the batch, and adds them to the running ones
+        void calculateOutputs(TensorView<const double> inputs, Arena &arena);
+
+        TensorView<const double> backPropagate(TensorView<const double> outputGradients, Arena &arena,
+                                               bool needInputGradients);
+
+        /* Writes the scale and shift every feature gets at inference, gamma / sqrt(runningVariance + epsilon) and
+           beta - runningMean * scale, into tensors of featureCount() values */
+        void inferenceTransform(Tensor<double> &scales, Tensor<double> &shifts) const;
+
+        /* Sets the running statistics to the average of those of the replicas (copies of this layer that trained on
+           shards of a batch), in their order, then copies them back into every replica. Without replicas they stay
+           as they are */
+        void mergeRunningStatistics(const std::vector<BatchNormLayer *> &replicas);
+
+        //Takes over the running statistics of another copy of this layer, which trained on the batch before
+        void copyRunningStatistics(const BatchNormLayer &other);
+
+        //Makes the layer hand the values over untouched, once its transform is part of the layer before it
+        void markFolded();
+
+        bool isFolded() const;
+    };
+}
+
+#endif //NEURALNETWORK_BATCHNORMLAYER_H
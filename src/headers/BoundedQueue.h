@@ -0,0 +1,69 @@
+#ifndef NEURALNETWORK_BOUNDEDQUEUE_H
+#define NEURALNETWORK_BOUNDEDQUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace neuralNet {
+    /* First in first out queue between threads holding at most capacity items: push waits while it is full and
+       pop while it is empty, so a producer can never run further ahead of its consumer than the capacity. Closing
+       the queue wakes everyone up, which is how a stage that failed stops the stages around it */
+    template<typename T>
+    class BoundedQueue {
+    private:
+        std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+        std::deque<T> items;
+        std::size_t capacity;
+        bool closed = false;
+
+    public:
+        explicit BoundedQueue(std::size_t capacity) : capacity(capacity) {}
+
+        //Waits for room and adds the item, returns false (dropping the item) when the queue is closed
+        bool push(T item) {
+            std::unique_lock<std::mutex> lock(mutex);
+            notFull.wait(lock, [this]() { return closed || items.size() < capacity; });
+            if (closed) {
+                return false;
+            }
+            items.push_back(std::move(item));
+            notEmpty.notify_one();
+            return true;
+        }
+
+        //Waits for an item and takes it, returns false once the queue is closed and nothing is left in it
+        bool pop(T &item) {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [this]() { return closed || !items.empty(); });
+            if (items.empty()) {
+                return false;
+            }
+            item = std::move(items.front());
+            items.pop_front();
+            notFull.notify_one();
+            return true;
+        }
+
+        //Makes every waiting and later push fail, and pop fail once the queue is drained
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            notEmpty.notify_all();
+            notFull.notify_all();
+        }
+
+        //Empties the queue and opens it again, when nobody is using it
+        void reset() {
+            std::lock_guard<std::mutex> lock(mutex);
+            items.clear();
+            closed = false;
+        }
+    };
+}
+
+#endif //NEURALNETWORK_BOUNDEDQUEUE_H
@@ -0,0 +1,177 @@
+#ifndef NEURALNETWORK_CONVOLUTIONLAYERS_H
+#define NEURALNETWORK_CONVOLUTIONLAYERS_H
+
+#include "Tensor.h"
+#include "Arena.h"
+#include "Activation.h"
+#include "ImageShape.h"
+#include "Initialization.h"
+
+namespace neuralNet {
+    /* 2D convolution followed by an activation function. Every sample is unrolled with im2col into a matrix with one
+       column per output pixel and one row per (input channel, kernel row, kernel column), so the whole convolution is
+       a single matrix multiplication with the kernels, done by the same blocked GEMM as everything else */
+    class Conv2DLayer {
+    private:
+        ImageShape inputShape;
+        ImageShape outputShape;
+        int kernelSize = 1;
+        int stride = 1;
+        int padding = 0;
+        ActivationFunction activation = ActivationFunction::Sigmoid;
+        InitScheme initialization = InitScheme::LeCun;
+
+        //Kernels of every output channel, indexed as [outChannel, inChannel * kernelSize * kernelSize]
+        TensorView<double> weights;
+
+        //One bias per output channel
+        TensorView<double> biases;
+
+        //Activations of the last batch, shaped [sample, outChannel * outHeight * outWidth], allocated from the arena
+        TensorView<double> activations;
+
+        //Points to the last batch of inputs it received, which must stay alive until the gradients are calculated
+        TensorView<const double> inputs;
+
+        //Cost gradients of the weights and biases, with the same shape as them
+        TensorView<double> costGradientW;
+        TensorView<double> costGradientB;
+
+        //Number of rows of the unrolled image, the values a single output pixel is calculated from
+        long patchSize() const;
+
+        //Number of pixels in each output channel
+        long outputPixels() const;
+
+        //Unrolls an image into columns, shaped [patchSize, outputPixels], padding with 0 outside the image
+        void im2col(const double *image, TensorView<double> columns) const;
+
+        //Adds every value of the unrolled columns back to the pixel of the image it was taken from
+        void col2im(TensorView<const double> columns, double *image) const;
+
+    public:
+        Conv2DLayer() = default;
+
+        /* Throws std::invalid_argument unless the channels, kernel size and stride are at least 1, the padding is
+           not negative and the kernel fits in the padded image */
+        Conv2DLayer(ImageShape inputShape, int outChannels, int kernelSize, int stride, int padding,
+                    ActivationFunction activation = ActivationFunction::Sigmoid,
+                    InitScheme initialization = InitScheme::Default);
+
+        const ImageShape &getOutputShape() const;
+
+        ActivationFunction getActivationFunction() const;
+
+        long parameterCount() const;
+
+        void bindParameters(TensorView<double> parameters, TensorView<double> gradients);
+
+        void initializeParameters(std::uint64_t seed);
+
+        std::size_t workspaceBytes(long batchSize) const;
+
+        TensorView<const double> getActivations() const;
+
+        //Returns the kernels, indexed as [outChannel, inChannel * kernelSize * kernelSize]
+        TensorView<const double> getWeights() const;
+
+        TensorView<const double> getBiases() const;
+
+        //Multiplies the kernel and bias of every output channel by its scale, then adds its shift to the bias
+        void foldScaleAndShift(TensorView<const double> scales, TensorView<const double> shifts);
+
+        /* Calculates the activations for a batch of inputs, without touching the state kept for back propagation.
+           The unrolled images are allocated from the arena */
+        void computeActivations(TensorView<const double> inputs, TensorView<double> outputs, Arena &arena) const;
+
+        //Calculates the outputs for a batch of inputs, keeping what the back propagation needs
+        void calculateOutputs(TensorView<const double> inputs, Arena &arena);
+
+        /* Takes the derivatives of the cost with respect to this layer's activations, adds the cost gradients of the
+           kernels and biases, and returns the derivatives with respect to its inputs when they are needed */
+        TensorView<const double> backPropagate(TensorView<const double> outputGradients, Arena &arena,
+                                               bool needInputGradients);
+    };
+
+    enum class PoolingType {
+        Max, Average
+    };
+
+    //Max or average pooling over square windows of every channel, it has no parameters
+    class PoolLayer {
+    private:
+        PoolingType type = PoolingType::Max;
+        ImageShape inputShape;
+        ImageShape outputShape;
+        int poolSize = 1;
+        int stride = 1;
+
+        TensorView<double> activations;
+
+        //Index (within the sample) of the input every output of max pooling was taken from
+        TensorView<int> maxIndices;
+
+        //Pools one sample, writing the index of every maximum when maxIndices is not null
+        void poolSample(const double *image, double *outputs, int *maxIndices) const;
+
+    public:
+        PoolLayer() = default;
+
+        //Throws std::invalid_argument unless the window and stride are at least 1 and the window fits in the image
+        PoolLayer(PoolingType type, ImageShape inputShape, int poolSize, int stride);
+
+        const ImageShape &getOutputShape() const;
+
+        long parameterCount() const;
+
+        void bindParameters(TensorView<double> parameters, TensorView<double> gradients);
+
+        void initializeParameters(std::uint64_t seed);
+
+        std::size_t workspaceBytes(long batchSize) const;
+
+        TensorView<const double> getActivations() const;
+
+        void computeActivations(TensorView<const double> inputs, TensorView<double> outputs, Arena &arena) const;
+
+        void calculateOutputs(TensorView<const double> inputs, Arena &arena);
+
+        //Routes the derivatives of the cost to the inputs each output was calculated from
+        TensorView<const double> backPropagate(TensorView<const double> outputGradients, Arena &arena,
+                                               bool needInputGradients);
+    };
+
+    /* Marks where the images stop being images and start being plain vectors for the dense layers. Images are
+       already stored as one row per sample, so both directions just hand the values over */
+    class FlattenLayer {
+    private:
+        ImageShape inputShape;
+        TensorView<const double> activations;
+
+    public:
+        FlattenLayer() = default;
+
+        explicit FlattenLayer(ImageShape inputShape);
+
+        ImageShape getOutputShape() const;
+
+        long parameterCount() const;
+
+        void bindParameters(TensorView<double> parameters, TensorView<double> gradients);
+
+        void initializeParameters(std::uint64_t seed);
+
+        std::size_t workspaceBytes(long batchSize) const;
+
+        TensorView<const double> getActivations() const;
+
+        void computeActivations(TensorView<const double> inputs, TensorView<double> outputs, Arena &arena) const;
+
+        void calculateOutputs(TensorView<const double> inputs, Arena &arena);
+
+        TensorView<const double> backPropagate(TensorView<const double> outputGradients, Arena &arena,
+                                               bool needInputGradients);
+    };
+}
+
+#endif //NEURALNETWORK_CONVOLUTIONLAYERS_H
@@ -0,0 +1,23 @@
+#ifndef NEURALNETWORK_CSVREADER_H
+#define NEURALNETWORK_CSVREADER_H
+
+#include <cstddef>
+#include <string>
+#include "Dataset.h"
+#include "ThreadPool.h"
+
+namespace neuralNet {
+    //Bytes of the file a task parses, the chunks being moved to the next line break
+    constexpr std::size_t csvChunkBytes = 1 << 20;
+
+    /* Reads a dataset from a CSV file holding a sample per line: the label, then inputSize values in [0, 255].
+       The file is mapped into memory and cut into chunks at line breaks, which the pool first counts the lines of
+       and then parses with std::from_chars, straight into the samples of the dataset, so nothing is allocated per
+       line or per value. Lines that are not a sample (a header, a wrong number of values, a value out of range)
+       are left out, and counted in skippedLines when it is given. Throws std::runtime_error when the file can not
+       be read */
+    Dataset readCsv(const std::string &path, int inputSize, int numClasses, long *skippedLines = nullptr,
+                    ThreadPool &pool = ThreadPool::global());
+}
+
+#endif //NEURALNETWORK_CSVREADER_H
@@ -0,0 +1,110 @@
+#ifndef NEURALNETWORK_DATASET_H
+#define NEURALNETWORK_DATASET_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Tensor.h"
+
+namespace neuralNet {
+    //A mini-batch converted to the type the network computes with, one sample per row
+    struct Batch {
+        //Inputs of each sample, shaped [sample, input]
+        Tensor<double> inputs;
+
+        //One-hot expected outputs of each sample, shaped [sample, output]
+        Tensor<double> expectedOutputs;
+
+        //Correct class of each sample
+        std::vector<int> labels;
+
+        int size() const {
+            return static_cast<int>(labels.size());
+        }
+
+        //Gives the batch the right shape for the number of samples, only allocating when the shape changed
+        void reshape(int count, int inputSize, int numClasses);
+
+        /* Converts a raw sample into a row: its inputs times inputScale, its label, and its one-hot expected
+           outputs, whose row must be all 0. Throws std::out_of_range when the label is not a class of the batch */
+        void setSample(int row, const std::uint8_t *sampleInputs, double inputScale, int label);
+    };
+
+    /* Stores a whole dataset as a structure of arrays: every input of every sample in one contiguous uint8
+       matrix, and the labels in an integer array. Inputs are only converted to doubles (and scaled) when a
+       batch is loaded, and the one-hot expected outputs are built there as well, so a 28x28 image takes
+       785 bytes instead of the ~6.3 KB two std::vector<double> per sample took. The inputs can also stay in
+       memory the dataset does not own, like a mapped file, which is only copied when samples are changed */
+    class Dataset {
+    private:
+        int inputSize;
+        int numClasses;
+
+        //Multiplies every input when a batch is loaded, 1/255 maps pixels to [0, 1]
+        double inputScale;
+
+        //Inputs of all the samples one after the other, shaped [sample, input]
+        std::vector<std::uint8_t> inputs;
+        std::vector<int> labels;
+
+        //Inputs the dataset views instead of its own, and whatever keeps them alive, nullptr when it owns them
+        const std::uint8_t *viewedInputs = nullptr;
+        std::shared_ptr<const void> viewedStorage;
+
+        //Copies viewed inputs into the dataset's own storage, before they are changed
+        void ownInputs();
+
+    public:
+        Dataset(int inputSize, int numClasses, double inputScale = 1.0 / 255.0);
+
+        /* Returns a dataset over labels.size() samples whose inputs are read from memory it does not copy, which
+           storage keeps alive for as long as the dataset (or a copy of it) uses it. Throws std::out_of_range when a
+           label is not a valid class */
+        static Dataset view(int inputSize, int numClasses, const std::uint8_t *inputs, std::vector<int> labels,
+                            std::shared_ptr<const void> storage, double inputScale = 1.0 / 255.0);
+
+        //Reserves room for a number of samples, so adding them does not reallocate
+        void reserve(int samples);
+
+        //Adds a sample, copying inputSize values from the pointer
+        void add(const std::uint8_t *sampleInputs, int label);
+
+        //Sets the number of samples, new ones being all zero with label 0, so they can be filled in place
+        void resize(int samples);
+
+        //Throws std::out_of_range when the label is not a valid class
+        void setLabel(int index, int label);
+
+        //Returns the number of samples
+        int size() const;
+
+        int sampleSize() const;
+
+        int classes() const;
+
+        //Returns the factor inputs are multiplied by when a batch is loaded
+        double scale() const;
+
+        //Returns the raw inputs of a sample
+        const std::uint8_t *sample(int index) const;
+
+        //Returns the inputs of a sample to change them, copying viewed inputs into the dataset first
+        std::uint8_t *mutableSample(int index);
+
+        int label(int index) const;
+
+        //Returns true when the inputs are viewed rather than owned
+        bool isView() const;
+
+        //Returns the number of bytes used to store the samples, viewed inputs included
+        std::size_t memoryUsage() const;
+
+        //Converts the samples [start, start + count) to a batch, reusing the batch's memory when it has the right size
+        void loadBatch(int start, int count, Batch &batch) const;
+
+        //Converts the samples at the given indices to a batch, reusing the batch's memory when it has the right size
+        void loadBatch(const std::vector<int> &indices, Batch &batch) const;
+    };
+}
+
+#endif //NEURALNETWORK_DATASET_H
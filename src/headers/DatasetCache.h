@@ -0,0 +1,25 @@
+#ifndef NEURALNETWORK_DATASETCACHE_H
+#define NEURALNETWORK_DATASETCACHE_H
+
+#include <functional>
+#include <string>
+#include "Dataset.h"
+
+namespace neuralNet {
+    //Returns the path of the cache of a source file: the source path followed by .nncache
+    std::string cachePath(const std::string &sourcePath);
+
+    /* Returns the dataset of a source file, parsed once and then read from a cache next to it. The cache holds the
+       packed dataset (labels, then the uint8 inputs) behind a header recording the size, modification time and a
+       hash of the content of the source, and the input size, classes and scale it was loaded with. When all of them
+       still match, the cache is mapped and its inputs are viewed in place, so nothing is parsed or copied. Otherwise
+       load is called to read the source, and its dataset is written to the cache for the next run (through a
+       temporary file, so a run that stops halfway leaves no broken cache). A cache that can not be written is
+       skipped. cacheHit, when given, tells whether the cache was used. Throws std::runtime_error when the source
+       can not be read */
+    Dataset loadWithCache(const std::string &sourcePath, int inputSize, int numClasses,
+                          const std::function<Dataset()> &load, double inputScale = 1.0 / 255.0,
+                          bool *cacheHit = nullptr);
+}
+
+#endif //NEURALNETWORK_DATASETCACHE_H
@@ -0,0 +1,171 @@
+#ifndef NEURALNETWORK_DENSELAYER_H
+#define NEURALNETWORK_DENSELAYER_H
+
+#include "Tensor.h"
+#include "Arena.h"
+#include "Activation.h"
+#include "ImageShape.h"
+#include "Initialization.h"
+
+namespace neuralNet {
+    //A batch of inputs stored as compressed sparse rows, keeping only the inputs that are not 0
+    struct SparseInputs {
+        //Sample s owns the entries [rowStarts[s], rowStarts[s + 1])
+        TensorView<int> rowStarts;
+
+        //Index of the input node and value of every entry
+        TensorView<int> columns;
+        TensorView<double> values;
+    };
+
+    //Bytes of weight rows (or gradient products) kept in the cache at once by the back propagation
+    constexpr std::size_t backPropagationTileBytes = 16 * 1024;
+
+    /* Number of doubles a vector register of the target holds, as the compiler flags set it: 8 with AVX-512, 4 with
+       AVX, 2 with SSE2 (any x86-64) or NEON */
+#if defined(__AVX512F__)
+    constexpr int vectorWidth = 8;
+#elif defined(__AVX__)
+    constexpr int vectorWidth = 4;
+#elif defined(__SSE2__) || defined(_M_X64) || defined(__ARM_NEON)
+    constexpr int vectorWidth = 2;
+#else
+    constexpr int vectorWidth = 1;
+#endif
+
+    /* Layers with fewer nodes than vectorWidth times this train with the across samples kernels, where the vector
+       lanes hold different samples instead of different nodes. Below that, a row of nodes is too short to keep the
+       vector units busy, and the batch (hundreds of samples) is a much longer loop to vectorize */
+    constexpr int acrossSamplesWidthFactor = 4;
+
+    //Fully connected layer: every node adds up all the inputs times their weights, then applies its activation function
+    class DenseLayer {
+    private:
+        int numNodesIn = 0;
+        int numNodesOut = 0;
+        ActivationFunction activation = ActivationFunction::Sigmoid;
+        InitScheme initialization = InitScheme::Gaussian;
+
+        //Weights of the connections between the last layer and this one, indexed as [nodeIn, nodeOut]
+        TensorView<double> weights;
+
+        //Biases for all the nodes of this layer, these acts as a sort of activation threshold
+        TensorView<double> biases;
+
+        /* Stores the activation values of each node for every sample of the last batch, shaped [sample, node].
+           They are allocated from the arena the batch was calculated with */
+        TensorView<double> activations;
+
+        /* Points to the last batch of inputs it received, which must stay alive until the gradients are calculated.
+           Used for calculating the derivative cost/weight */
+        TensorView<const double> inputs;
+
+        /* When the fraction of inputs that are not 0 is below this, the inputs are compressed and only the weight
+           rows of the non zero inputs are used, both for the outputs and the gradients */
+        double sparseDensityThreshold = 0;
+
+        //Compressed copy of the last batch of inputs, only valid when inputsAreSparse is true
+        SparseInputs sparseInputs;
+        bool inputsAreSparse = false;
+
+        //Whether the layer is narrow enough for the across samples kernels, and whether the last batch used them
+        bool acrossSamples = false;
+        bool batchAcrossSamples = false;
+
+        //The last batch of inputs stored as [nodeIn, sample], only valid when batchAcrossSamples is true
+        TensorView<double> transposedInputs;
+
+        //These store the gradient of the cost for a given weight or bias, with the same shape as the weights and biases
+        TensorView<double> costGradientW;
+        TensorView<double> costGradientB;
+
+        /* Compresses the inputs into sparseInputs when few enough of them are not 0, returns false
+           (without allocating anything) when the batch is too dense for it to pay off */
+        bool compressInputs(TensorView<const double> inputs, Arena &arena);
+
+        //Calculates the activations of a batch of compressed inputs, only reading the weight rows of non zero inputs
+        void computeSparseActivations(const SparseInputs &inputs, TensorView<double> outputs) const;
+
+        /* Calculates the activations from inputs stored as [nodeIn, sample], with the samples in the inner loop.
+           The weighted inputs are added up as [nodeOut, sample] and only transposed into outputs at the end */
+        void computeActivationsAcrossSamples(TensorView<const double> transposedInputs, TensorView<double> outputs,
+                                             Arena &arena) const;
+
+        //backPropagate for batches that went through computeActivationsAcrossSamples, also with samples innermost
+        TensorView<const double> backPropagateAcrossSamples(TensorView<const double> gradientProducts, Arena &arena,
+                                                            bool needInputGradients);
+
+        /* Adds the cost gradients of the weights and biases from the gradient products (derivatives of the cost with
+           respect to the weighted inputs), only visiting the weight rows of non zero inputs when they are sparse */
+        void calculateGradients(TensorView<const double> gradientProducts);
+
+    public:
+        DenseLayer() = default;
+
+        //Initializes a layer with the number of incoming nodes and outgoing nodes
+        DenseLayer(int numNodesIn, int numNodesOut, ActivationFunction activation = ActivationFunction::Sigmoid,
+                   InitScheme initialization = InitScheme::Default);
+
+        //Returns the number of nodes in this layer
+        int length() const;
+
+        //Returns the number of incoming nodes
+        int nodesIn() const;
+
+        ImageShape getOutputShape() const;
+
+        ActivationFunction getActivationFunction() const;
+
+        //Sets the density of non zero inputs under which the sparse kernels are used, 0 disables them
+        void setSparseDensityThreshold(double threshold);
+
+        double getSparseDensityThreshold() const;
+
+        //Turns the across samples kernels on or off, by default they are on for layers narrower than the vectors
+        void setAcrossSamples(bool enabled);
+
+        bool getAcrossSamples() const;
+
+        //Returns the number of weights and biases
+        long parameterCount() const;
+
+        //Points the weights, biases and their cost gradients at slices of the network's parameter buffers
+        void bindParameters(TensorView<double> parameters, TensorView<double> gradients);
+
+        //Assigns random weights and biases with the initialization scheme, the same seed always giving the same ones
+        void initializeParameters(std::uint64_t seed);
+
+        //Returns the number of bytes calculateOutputs and backPropagate take from the arena for a batch
+        std::size_t workspaceBytes(long batchSize) const;
+
+        //Returns the activation numbers
+        TensorView<const double> getActivations() const;
+
+        //Returns the weights of the connections between the last layer and this one
+        TensorView<const double> getWeights() const;
+
+        //Returns the biases of the nodes of this layer
+        TensorView<const double> getBiases() const;
+
+        /* Multiplies the weights and bias of every node by its scale, then adds its shift to the bias, which is the
+           same as scaling and shifting the weighted inputs. Folds a following normalization into the layer */
+        void foldScaleAndShift(TensorView<const double> scales, TensorView<const double> shifts);
+
+        /* Calculates the activations for a batch of inputs, shaped [sample, node], without touching the state
+           kept for back propagation */
+        void computeActivations(TensorView<const double> inputs, TensorView<double> outputs, Arena &arena) const;
+
+        //Calculates the outputs (values of all the nodes of this layer) for a batch of inputs, shaped [sample, node]
+        void calculateOutputs(TensorView<const double> inputs, Arena &arena);
+
+        /* Takes the derivatives of the cost with respect to this layer's activations, adds the cost gradients of its
+           weights and biases, and returns the derivatives with respect to its inputs (allocated from the arena) when
+           they are needed. The gradients and the derivatives come out of a single pass over the weight matrix */
+        TensorView<const double> backPropagate(TensorView<const double> outputGradients, Arena &arena,
+                                               bool needInputGradients);
+
+        void printNodes() const;
+    };
+}
+
+#endif //NEURALNETWORK_DENSELAYER_H
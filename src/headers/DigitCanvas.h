@@ -0,0 +1,80 @@
+#ifndef NEURALNETWORK_DIGITCANVAS_H
+#define NEURALNETWORK_DIGITCANVAS_H
+
+#include <GLFW/glfw3.h>
+#include <vector>
+#include "NeuralNetwork.h"
+#include "../../libs/imgui/imgui.h"
+
+/* A canvas the user can draw a digit on with the mouse. Every time a stroke changes the drawing, it is
+   downsampled to the input size of the network (28x28 for MNIST) and classified, so the canvas also
+   measures the latency of the inference path while the render loop and training are running */
+class DigitCanvas {
+private:
+    neuralNet::NeuralNetwork *network = nullptr;
+
+    //The network sees a side x side image, the canvas is drawn at scale times that resolution
+    int side = 0;
+    int scale = 10;
+    int canvasSide = 0;
+
+    float brushRadius = 10.0f;
+    bool centerDigit = true;
+
+    //Intensity of each canvas pixel between 0 and 1, and its downsampled version fed to the network
+    std::vector<float> canvas;
+    neuralNet::Tensor<double> inputs;
+
+    //Outputs of the network for the current drawing
+    neuralNet::Tensor<double> outputs;
+    int prediction = -1;
+
+    bool drawing = false;
+    ImVec2 lastPoint;
+
+    //Set when the drawing changed, so the textures only get uploaded when needed
+    bool dirty = true;
+    GLuint canvasTexture = 0;
+    GLuint inputsTexture = 0;
+    std::vector<unsigned char> pixels;
+
+    //Latency of the last classifications in microseconds, stored as a ring buffer
+    std::vector<float> latencies;
+    int latencyIndex = 0;
+    long classifications = 0;
+
+    //Paints a round brush stroke between two points in canvas coordinates
+    void paintLine(ImVec2 from, ImVec2 to);
+
+    //Paints a single round dab of the brush
+    void paintDot(ImVec2 center);
+
+    //Averages the canvas down to the input size of the network, optionally centering it like MNIST does
+    void downsample();
+
+    //Runs the drawing through the network and records how long it took
+    void classify();
+
+    //Uploads the canvas and the downsampled inputs to their textures
+    void uploadTextures();
+
+    //Shows the latency history and its percentiles
+    void drawLatencyStats();
+
+public:
+    DigitCanvas() = default;
+
+    //Sets the network used to classify the drawing, it is not owned by the canvas
+    void attach(neuralNet::NeuralNetwork *network);
+
+    //Draws the canvas window, must be called between ImGui::NewFrame() and ImGui::Render()
+    void draw();
+
+    //Erases the drawing
+    void clear();
+
+    //Deletes the textures, must be called while the OpenGL context is still alive
+    void release();
+};
+
+#endif //NEURALNETWORK_DIGITCANVAS_H
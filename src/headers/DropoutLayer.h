@@ -0,0 +1,86 @@
+#ifndef NEURALNETWORK_DROPOUTLAYER_H
+#define NEURALNETWORK_DROPOUTLAYER_H
+
+#include <cstdint>
+#include "Tensor.h"
+#include "Arena.h"
+#include "ImageShape.h"
+#include "Random.h"
+
+namespace neuralNet {
+    /* Sets a random fraction (the rate) of its inputs to 0 during training, and scales the others by 1 / (1 - rate)
+       so the expected value of every output stays the same ("inverted dropout"). Thanks to the scaling, inference
+       has nothing to do: computeActivations hands the inputs over, and the network skips the layer entirely.
+       Which values are kept is stored as one bit per value, and the bits come from Philox, 16 bits of randomness
+       per value, with the sample and the step in the counter. The keep probability is rounded to a multiple of
+       1 / 65536, and the scale uses the rounded value, so the outputs stay unbiased */
+    class DropoutLayer {
+    private:
+        //Number of values a mask word holds, and number of random bits compared against the keep threshold per value
+        static constexpr int bitsPerWord = 32;
+        static constexpr int randomBitsPerValue = 16;
+
+        double rate = 0;
+        ImageShape shape;
+
+        //A value is kept when its 16 random bits are below this, and kept values are multiplied by scale
+        std::uint32_t keepThreshold = 1u << randomBitsPerValue;
+        double scale = 1;
+
+        Philox::Key key{};
+
+        //Incremented every training batch, so each one gets new masks
+        std::uint64_t step = 0;
+
+        //Index of the first sample of the batch within the whole batch, when it is one shard of a bigger one
+        long firstSample = 0;
+
+        TensorView<double> activations;
+
+        //Which values of the last batch were kept, one bit per value, shaped [sample, word]
+        TensorView<std::uint32_t> masks;
+
+        //Number of mask words of a sample
+        long wordsPerSample() const;
+
+        //Fills the mask of every sample of the batch, from the step and the index of the sample
+        void generateMasks(long batchSize);
+
+    public:
+        DropoutLayer() = default;
+
+        //Throws std::invalid_argument when the rate is not in [0, 1)
+        DropoutLayer(double rate, ImageShape shape);
+
+        const ImageShape &getOutputShape() const;
+
+        double getRate() const;
+
+        long parameterCount() const;
+
+        void bindParameters(TensorView<double> parameters, TensorView<double> gradients);
+
+        //Has no parameters, but takes the key of its masks from the seed
+        void initializeParameters(std::uint64_t seed);
+
+        std::size_t workspaceBytes(long batchSize) const;
+
+        TensorView<const double> getActivations() const;
+
+        //Inference does not drop anything, so the outputs are the inputs
+        void computeActivations(TensorView<const double> inputs, TensorView<double> outputs, Arena &arena) const;
+
+        /* Makes the next batch use the masks of the given step, its first sample being sample firstSample of the
+           whole batch, so a batch split into shards gets the same masks as it would in one piece */
+        void setPosition(std::uint64_t step, long firstSample);
+
+        //Drops values with a new mask for every sample
+        void calculateOutputs(TensorView<const double> inputs, Arena &arena);
+
+        //Lets the derivatives of the cost through for the values that were kept, scaled the same way
+        TensorView<const double> backPropagate(TensorView<const double> outputGradients, Arena &arena,
+                                               bool needInputGradients);
+    };
+}
+
+#endif //NEURALNETWORK_DROPOUTLAYER_H
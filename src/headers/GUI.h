@@ -7,6 +7,8 @@
 
 #include <GLFW/glfw3.h>
 #include <thread>
+#include "Visualizer.h"
+#include "DigitCanvas.h"
 
 class GUIWindow {
 private:
@@ -15,6 +17,8 @@ private:
     int height;
     const char* title;
     std::thread renderThread;
+    NetworkVisualizer visualizer;
+    DigitCanvas canvas;
 
     //Initializes the GUIWindow
     void initialize();
@@ -34,6 +38,9 @@ public:
 
     //Used to wait for the rendering thread to finish
     void join();
+
+    //Shows the weights and activations of the network for the dataset, and lets the user draw digits for it to classify
+    void attachNetwork(neuralNet::NeuralNetwork* network, const neuralNet::Dataset* dataset);
 };
 
 #endif //NEURALNETWORK_GUI_H
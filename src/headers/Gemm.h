@@ -0,0 +1,19 @@
+#ifndef NEURALNETWORK_GEMM_H
+#define NEURALNETWORK_GEMM_H
+
+#include "Tensor.h"
+
+namespace neuralNet {
+    //Sizes of the blocks the matrices are cut into, picked so a block of a and b stay in the L2 cache together
+    constexpr long gemmBlockRows = 64;
+    constexpr long gemmBlockDepth = 256;
+    constexpr long gemmBlockColumns = 512;
+
+    /* Matrix multiplication c = a * b, or c += a * b when accumulate is true. a is [m, k], b is [k, n] and
+       c is [m, n]. The inputs can be any strided view, so transposed operands are passed with
+       TensorView::transpose() instead of being copied. Blocks of a and b are packed into contiguous,
+       aligned buffers first, so the inner loop always runs over contiguous memory and can be vectorized */
+    void gemm(TensorView<const double> a, TensorView<const double> b, TensorView<double> c, bool accumulate = false);
+}
+
+#endif //NEURALNETWORK_GEMM_H
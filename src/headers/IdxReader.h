@@ -0,0 +1,46 @@
+#ifndef NEURALNETWORK_IDXREADER_H
+#define NEURALNETWORK_IDXREADER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Dataset.h"
+#include "MappedFile.h"
+
+namespace neuralNet {
+    /* A file in the IDX format of the original MNIST and Fashion-MNIST: a big-endian header (two zero bytes, the
+       type of the values, the number of dimensions, then each dimension as a 32 bit integer) followed by the values
+       row-major. Only unsigned bytes (type 0x08) are supported. The file is mapped, and its values are read in
+       place. Throws std::runtime_error when the file can not be read, or when its header does not match its size */
+    class IdxFile {
+    private:
+        static constexpr std::uint8_t unsignedByteType = 0x08;
+
+        MappedFile file;
+        std::vector<long> dims;
+
+    public:
+        explicit IdxFile(const std::string &path);
+
+        //Returns the dimensions, the first one being the number of items
+        const std::vector<long> &dimensions() const;
+
+        //Returns the number of items, the first dimension
+        long count() const;
+
+        //Returns the number of values of an item, the product of the other dimensions
+        long itemSize() const;
+
+        //Returns the first value, right after the header
+        const std::uint8_t *values() const;
+    };
+
+    /* Returns a dataset viewing the images of an IDX file in place, the samples being the first dimension, with the
+       labels of another one (with one dimension). The mapped images stay alive as long as the dataset or a copy of
+       it does, and are only converted to doubles (and scaled) when a batch is loaded. Throws std::runtime_error when
+       the files do not hold the same number of samples or a label is not a valid class */
+    Dataset readIdx(const std::string &imagesPath, const std::string &labelsPath, int numClasses = 10);
+}
+
+#endif //NEURALNETWORK_IDXREADER_H
@@ -0,0 +1,19 @@
+#ifndef NEURALNETWORK_IMAGESHAPE_H
+#define NEURALNETWORK_IMAGESHAPE_H
+
+namespace neuralNet {
+    /* Shape of the image every sample is made of. A batch of images is still a [sample, value] matrix,
+       each row holding the image channel after channel, and each channel row after row. Layers that do not
+       work on images output a single row of values */
+    struct ImageShape {
+        int channels = 1;
+        int height = 1;
+        int width = 1;
+
+        long size() const {
+            return static_cast<long>(channels) * height * width;
+        }
+    };
+}
+
+#endif //NEURALNETWORK_IMAGESHAPE_H
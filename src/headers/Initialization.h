@@ -0,0 +1,38 @@
+#ifndef NEURALNETWORK_INITIALIZATION_H
+#define NEURALNETWORK_INITIALIZATION_H
+
+#include <cstdint>
+#include "Tensor.h"
+
+namespace neuralNet {
+    /* How the weights of a layer start out. The deviations depend on fanIn (values each output adds up) and fanOut
+       (outputs each input goes to):
+         Gaussian    N(0, 1) weights and biases
+         LeCun       N(0, 1 / sqrt(fanIn)) weights and biases
+         Xavier      N(0, sqrt(2 / (fanIn + fanOut))) weights and zero biases, for sigmoid and tanh
+         He          N(0, sqrt(2 / fanIn)) weights and zero biases, for ReLU
+         Orthogonal  orthonormal rows (or columns, whichever are fewer) and zero biases
+       Default lets the layer pick: Gaussian for dense layers and LeCun for convolutions */
+    enum class InitScheme {
+        Default, Gaussian, LeCun, Xavier, He, Orthogonal
+    };
+
+    //Values generated per task when initializing in parallel, a multiple of the 4 values of a Philox counter
+    constexpr long initializationChunkSize = 64 * 1024;
+
+    //Philox streams the weights and the biases of a layer are drawn from, with the key of the layer's seed
+    constexpr std::uint32_t weightInitStream = 0;
+    constexpr std::uint32_t biasInitStream = 1;
+
+    /* Fills the weights and biases of a layer with the scheme, which must not be Default. The random numbers only
+       depend on the seed and on the position of each value, so the result is the same for any number of threads.
+       The weights must be a contiguous [rows, columns] view */
+    void initializeWeights(InitScheme scheme, TensorView<double> weights, TensorView<double> biases, long fanIn,
+                           long fanOut, std::uint64_t seed);
+
+    /* Makes the rows of the matrix orthonormal when there are no more rows than columns, otherwise the columns,
+       with a blocked Gram-Schmidt whose updates are matrix multiplications spread over the thread pool */
+    void orthonormalize(TensorView<double> matrix);
+}
+
+#endif //NEURALNETWORK_INITIALIZATION_H
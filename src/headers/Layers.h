@@ -0,0 +1,28 @@
+#ifndef NEURALNETWORK_LAYERS_H
+#define NEURALNETWORK_LAYERS_H
+
+#include <variant>
+#include "DenseLayer.h"
+#include "ConvolutionLayers.h"
+#include "ActivationLayer.h"
+#include "DropoutLayer.h"
+#include "BatchNormLayer.h"
+
+namespace neuralNet {
+    /* Every kind of layer a network can be made of. They all provide the same functions, called through std::visit,
+       so there is no virtual call for every value: the type is looked up once per layer and batch, and the loops
+       inside each layer are compiled for that layer alone. Every layer provides:
+         getOutputShape()                              shape of the values it outputs for a sample
+         parameterCount(), bindParameters(), initializeParameters(seed)
+                                                       its weights are slices of the network's flat buffers
+         workspaceBytes(batchSize)                     how much of the arena a training step takes from it
+         computeActivations(inputs, outputs, arena)    inference, without touching the back propagation state
+         calculateOutputs(inputs, arena), getActivations()
+                                                       forward pass, keeping what the back propagation needs
+         backPropagate(outputGradients, arena, needInputGradients)
+                                                       adds its cost gradients and returns those of its inputs */
+    using NetworkLayer = std::variant<DenseLayer, Conv2DLayer, PoolLayer, FlattenLayer, ActivationLayer, DropoutLayer,
+                                      BatchNormLayer>;
+}
+
+#endif //NEURALNETWORK_LAYERS_H
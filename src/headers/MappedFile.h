@@ -0,0 +1,41 @@
+#ifndef NEURALNETWORK_MAPPEDFILE_H
+#define NEURALNETWORK_MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace neuralNet {
+    /* A whole file mapped read-only into memory (mmap, or a file mapping on Windows), so it is read straight from
+       the page cache without copying it into a buffer first. An empty file maps to no memory at all. Throws
+       std::runtime_error when the file can not be opened or mapped */
+    class MappedFile {
+    private:
+        const std::uint8_t *address = nullptr;
+        std::size_t bytes = 0;
+
+        //The file mapping object on Windows, unused elsewhere
+        void *mapping = nullptr;
+
+        void release();
+
+    public:
+        MappedFile() = default;
+
+        explicit MappedFile(const std::string &path);
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+
+        ~MappedFile();
+
+        const std::uint8_t *data() const;
+
+        std::size_t size() const;
+    };
+}
+
+#endif //NEURALNETWORK_MAPPEDFILE_H
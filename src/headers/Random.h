@@ -0,0 +1,139 @@
+#ifndef NEURALNETWORK_RANDOM_H
+#define NEURALNETWORK_RANDOM_H
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+namespace neuralNet {
+    /* Philox4x32-10 counter based random number generator (Salmon et al., "Parallel random numbers: as easy as
+       1, 2, 3"). It has no state: the same key and counter always give the same 4 numbers, and different counters
+       give independent ones. So every thread can generate the numbers of any sample (by putting the sample and the
+       step in the counter) without sharing or locking anything, and the results do not depend on the thread count */
+    class Philox {
+    public:
+        using Counter = std::array<std::uint32_t, 4>;
+        using Key = std::array<std::uint32_t, 2>;
+
+    private:
+        static constexpr std::uint32_t multiplier0 = 0xD2511F53;
+        static constexpr std::uint32_t multiplier1 = 0xCD9E8D57;
+        static constexpr std::uint32_t weyl0 = 0x9E3779B9;
+        static constexpr std::uint32_t weyl1 = 0xBB67AE85;
+        static constexpr int rounds = 10;
+
+        //Number of counters generateBlock works on side by side, so the rounds vectorize across them
+        static constexpr int lanes = 8;
+
+    public:
+        //Splits a 64 bit seed into a key
+        static Key key(std::uint64_t seed) {
+            return {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+        }
+
+        //Returns the 4 random numbers of a counter
+        static Counter generate(Counter counter, Key key) {
+            for (int round = 0; round < rounds; round++) {
+                std::uint64_t product0 = static_cast<std::uint64_t>(multiplier0) * counter[0];
+                std::uint64_t product1 = static_cast<std::uint64_t>(multiplier1) * counter[2];
+                counter = {static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                           static_cast<std::uint32_t>(product1),
+                           static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                           static_cast<std::uint32_t>(product0)};
+                key = {key[0] + weyl0, key[1] + weyl1};
+            }
+            return counter;
+        }
+
+        /* Writes the numbers of count / 4 consecutive counters (counter, then counter[0] + 1, ...) to values, 4 per
+           counter, count being a multiple of 4. The counters are generated a group of lanes at a time, with every
+           round written as a loop over the lanes, which the compiler turns into vector multiplications */
+        static void generateBlock(Counter counter, Key key, std::uint32_t *values, long count) {
+            long blocks = count / 4;
+            long block = 0;
+            for (; block + lanes <= blocks; block += lanes) {
+                std::uint32_t x0[lanes], x1[lanes], x2[lanes], x3[lanes];
+                for (int lane = 0; lane < lanes; lane++) {
+                    x0[lane] = counter[0] + static_cast<std::uint32_t>(block + lane);
+                    x1[lane] = counter[1];
+                    x2[lane] = counter[2];
+                    x3[lane] = counter[3];
+                }
+
+                Key roundKey = key;
+                for (int round = 0; round < rounds; round++) {
+                    for (int lane = 0; lane < lanes; lane++) {
+                        std::uint64_t product0 = static_cast<std::uint64_t>(multiplier0) * x0[lane];
+                        std::uint64_t product1 = static_cast<std::uint64_t>(multiplier1) * x2[lane];
+                        x0[lane] = static_cast<std::uint32_t>(product1 >> 32) ^ x1[lane] ^ roundKey[0];
+                        x1[lane] = static_cast<std::uint32_t>(product1);
+                        x2[lane] = static_cast<std::uint32_t>(product0 >> 32) ^ x3[lane] ^ roundKey[1];
+                        x3[lane] = static_cast<std::uint32_t>(product0);
+                    }
+                    roundKey = {roundKey[0] + weyl0, roundKey[1] + weyl1};
+                }
+
+                for (int lane = 0; lane < lanes; lane++) {
+                    std::uint32_t *laneValues = values + (block + lane) * 4;
+                    laneValues[0] = x0[lane];
+                    laneValues[1] = x1[lane];
+                    laneValues[2] = x2[lane];
+                    laneValues[3] = x3[lane];
+                }
+            }
+
+            //The last counters that do not fill a group
+            for (; block < blocks; block++) {
+                Counter numbers = generate({counter[0] + static_cast<std::uint32_t>(block), counter[1], counter[2],
+                                            counter[3]}, key);
+                for (int index = 0; index < 4; index++) {
+                    values[block * 4 + index] = numbers[index];
+                }
+            }
+        }
+    };
+
+    //SplitMix64 finalizer: turns a seed and a stream number into an unrelated seed, used to give every part its own key
+    inline std::uint64_t mixSeed(std::uint64_t seed, std::uint64_t stream) {
+        std::uint64_t mixed = seed + (stream + 1) * 0x9E3779B97F4A7C15ull;
+        mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ull;
+        mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBull;
+        return mixed ^ (mixed >> 31);
+    }
+
+    //Returns a seed from the operating system, for when no seed is given
+    inline std::uint64_t randomSeed() {
+        std::random_device device;
+        return static_cast<std::uint64_t>(device()) << 32 | device();
+    }
+
+    /* Writes count values of N(0, deviation) to values, starting at index first of the stream. The values at
+       indices 4n to 4n + 3 come from the counter {n, stream, n >> 32, 0}, through the Box-Muller transform, so any
+       range of indices can be generated on its own and gives the same numbers, whichever thread fills it */
+    inline void fillNormal(double *values, long first, long count, double deviation, Philox::Key key,
+                           std::uint32_t stream) {
+        constexpr double toUnit = 1.0 / 4294967296.0;
+        constexpr double twoPi = 6.283185307179586;
+
+        for (long index = first; index < first + count;) {
+            long block = index / 4;
+            Philox::Counter numbers = Philox::generate({static_cast<std::uint32_t>(block), stream,
+                                                        static_cast<std::uint32_t>(block >> 32), 0}, key);
+
+            //Every pair of numbers gives two normal values, the first of the pair being in (0, 1] for the log
+            double normals[4];
+            for (int pair = 0; pair < 2; pair++) {
+                double radius = std::sqrt(-2 * std::log((numbers[2 * pair] + 1.0) * toUnit)) * deviation;
+                double angle = twoPi * numbers[2 * pair + 1] * toUnit;
+                normals[2 * pair] = radius * std::cos(angle);
+                normals[2 * pair + 1] = radius * std::sin(angle);
+            }
+            for (; index < first + count && index / 4 == block; index++) {
+                values[index - first] = normals[index % 4];
+            }
+        }
+    }
+}
+
+#endif //NEURALNETWORK_RANDOM_H
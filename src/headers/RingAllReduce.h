@@ -0,0 +1,93 @@
+#ifndef NEURALNETWORK_RINGALLREDUCE_H
+#define NEURALNETWORK_RINGALLREDUCE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Socket.h"
+
+namespace neuralNet {
+    //Bytes of gradients the back propagation gathers before the ring starts adding them up over the processes
+    constexpr std::size_t defaultBucketBytes = 1 << 20;
+
+    //Seconds to wait for the other processes of a ring when connecting
+    constexpr int defaultRingTimeout = 60;
+
+    /* Joins the processes of a data parallel training into a ring over TCP, each one sending to the next and
+       receiving from the one before, and adds up buffers of doubles over all of them. A buffer is cut into a segment
+       per process: a first lap adds every segment up as it goes around (reduce-scatter), a second one hands the
+       finished sums around (all-gather). Every process sends and receives 2 * (n - 1) / n of the buffer whatever
+       their number, and each sum is computed in one place, so every process ends up with bitwise identical values.
+       The sums run on a thread of their own, so a buffer can be added up while the caller keeps working. Every
+       process must start the same buffers, with the same sizes, in the same order. The values are sent as they are
+       in memory, so the machines must agree on the format of a double */
+    class RingAllReduce {
+    private:
+        //Part of a buffer waiting to be added up
+        struct Span {
+            double *values;
+            long count;
+        };
+
+        int processRank = 0;
+        int processCount = 1;
+
+        Socket next;
+        Socket previous;
+
+        //Segments received during the first lap, before they are added to the buffer
+        std::vector<double> receiveBuffer;
+
+        std::thread worker;
+        std::mutex stateMutex;
+        std::condition_variable workAdded;
+        std::condition_variable workDone;
+        std::deque<Span> pending;
+        bool busy = false;
+        bool stopping = false;
+
+        //First error of the communication thread, rethrown by wait
+        std::exception_ptr error;
+
+        void workerLoop();
+
+        //Adds a buffer up over the ring, on the calling thread
+        void reduce(double *values, long count);
+
+    public:
+        /* Connects process rank to the others, addresses holding the "host:port" every process listens on, in rank
+           order. Every process of the ring must be built with the same addresses, within timeoutSeconds of each
+           other. Throws std::invalid_argument for a bad rank or address and std::runtime_error when connecting fails */
+        RingAllReduce(int rank, const std::vector<std::string> &addresses, int timeoutSeconds = defaultRingTimeout);
+
+        RingAllReduce(const RingAllReduce &) = delete;
+        RingAllReduce &operator=(const RingAllReduce &) = delete;
+
+        ~RingAllReduce();
+
+        int rank() const;
+
+        //Returns the number of processes in the ring
+        int size() const;
+
+        /* Queues a buffer to be replaced by its sum over every process and returns right away. The buffer must not
+           be touched until wait returns */
+        void startAllReduce(double *values, long count);
+
+        //Waits until every queued buffer is added up, rethrowing the first error the communication hit
+        void wait();
+
+        //Replaces the values by their sum over every process
+        void allReduce(double *values, long count);
+
+        //Copies the values of process 0 to every other process
+        void broadcast(double *values, long count);
+    };
+}
+
+#endif //NEURALNETWORK_RINGALLREDUCE_H
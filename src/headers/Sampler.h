@@ -0,0 +1,58 @@
+#ifndef NEURALNETWORK_SAMPLER_H
+#define NEURALNETWORK_SAMPLER_H
+
+#include <cstdint>
+#include <vector>
+#include "Random.h"
+
+namespace neuralNet {
+    /* Picks the samples of batches in a new random order every epoch, without ever storing the order: the sample at
+       a position is a keyed bijection of [0, sampleCount), a Feistel network on the bits of the position (its rounds
+       being Philox with the epoch in the counter), walked again while it falls outside of the range. Its memory does
+       not grow with the dataset, and the sample at any position is known without computing the ones before it.
+       With several ranks (loader processes, or the processes of a data parallel training), rank r takes the
+       positions r, r + ranks, ... of the same order, so the ranks read disjoint samples. Every rank gets the same
+       number of whole batches per epoch, the positions left over are skipped. A sampler is an IndexSampler, so it
+       can be handed to a BatchLoader directly */
+    class Sampler {
+    private:
+        static constexpr int feistelRounds = 4;
+
+        long sampleCount;
+        int batchSize;
+        Philox::Key key;
+        int rank;
+        int rankCount;
+
+        //Epochs to go through before running out, 0 for no end
+        long epochLimit;
+
+        //Bits of each half of a Feistel block, which covers [0, 4^halfBits)
+        int halfBits = 1;
+
+        long currentEpoch = 0;
+        long nextBatch = 0;
+
+    public:
+        /* Throws std::invalid_argument for a batch bigger than the share of a rank, or a rank that is not in
+           [0, rankCount) */
+        Sampler(long sampleCount, int batchSize, std::uint64_t seed = randomSeed(), int rank = 0, int rankCount = 1,
+                long epochLimit = 0);
+
+        //Returns the sample at a position of the order of an epoch
+        long sampleAt(long epoch, long position) const;
+
+        //Returns the number of batches every rank gets per epoch
+        long batchesPerEpoch() const;
+
+        long epoch() const;
+
+        //Starts over at the first batch of an epoch, to resume a training
+        void setEpoch(long epoch);
+
+        //Fills the samples of the next batch of this rank, returns false once epochLimit epochs are done
+        bool operator()(std::vector<int> &indices);
+    };
+}
+
+#endif //NEURALNETWORK_SAMPLER_H
@@ -0,0 +1,130 @@
+#ifndef NEURALNETWORK_SHARDEDDATASET_H
+#define NEURALNETWORK_SHARDEDDATASET_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Dataset.h"
+#include "MappedFile.h"
+
+namespace neuralNet {
+    //Samples a shard holds by default, 64 MB of 28x28 images
+    constexpr int defaultSamplesPerShard = 1 << 16;
+
+    /* A dataset too big to keep in one file or in memory is cut into shard files of a fixed number of samples, next
+       to an index file mapping every sample id to its shard and the offset of its record there:
+           base.index          header, then a 64 bit entry per sample: shard << 40 | offset
+           base-00000.shard    header, then a record per sample: a 32 bit label and the inputs
+       The numbers are written as they are in memory, a reader with another byte order failing on the magic
+       numbers. Shuffling (see Sampler) only ever touches sample ids, and any thread or process can read any sample
+       without reading the ones before it */
+    namespace shardFormat {
+        constexpr std::uint64_t indexMagic = 0x4E4E494E44455831ull;
+        constexpr std::uint64_t shardMagic = 0x4E4E534841524431ull;
+
+        //Bits of an index entry holding the offset, the ones above it hold the shard
+        constexpr int offsetBits = 40;
+
+        struct IndexHeader {
+            std::uint64_t magic;
+            std::int64_t sampleCount;
+            std::int32_t inputSize;
+            std::int32_t numClasses;
+            std::int32_t shardCount;
+            std::int32_t reserved;
+            double inputScale;
+        };
+
+        struct ShardHeader {
+            std::uint64_t magic;
+            std::int64_t sampleCount;
+            std::int32_t shard;
+            std::int32_t inputSize;
+        };
+
+        //Returns the path of a shard: the base, a dash and the shard number on 5 digits
+        std::string shardPath(const std::string &basePath, int shard);
+    }
+
+    /* Writes a sharded dataset one sample after the other, starting a new shard every samplesPerShard samples. The
+       index is only written by finish, so a dataset is not readable before it is complete. Throws
+       std::runtime_error when a file can not be written */
+    class ShardWriter {
+    private:
+        std::string basePath;
+        int inputSize;
+        int numClasses;
+        int samplesPerShard;
+        double inputScale;
+
+        std::ofstream shard;
+        int shardCount = 0;
+        long samplesInShard = 0;
+        std::vector<std::uint64_t> entries;
+
+        //Writes the header of the shard being written, with the number of samples it holds so far
+        void writeShardHeader();
+
+        void closeShard();
+
+    public:
+        ShardWriter(std::string basePath, int inputSize, int numClasses, int samplesPerShard = defaultSamplesPerShard,
+                    double inputScale = 1.0 / 255.0);
+
+        //Appends a sample, throws std::out_of_range when the label is not a valid class
+        void add(const std::uint8_t *sampleInputs, int label);
+
+        //Closes the last shard and writes the index
+        void finish();
+    };
+
+    //Writes every sample of a dataset to shards, in order
+    void writeShards(const Dataset &dataset, const std::string &basePath,
+                     int samplesPerShard = defaultSamplesPerShard);
+
+    /* Reads a sharded dataset in place: the index and every shard are mapped, and the inputs of a sample are read
+       straight from its shard when a batch is loaded, so opening a dataset reads nothing but the headers. The pages
+       of the samples nobody asks for are never read from disk. Every method is const and reads mapped memory only,
+       so any number of threads can load batches at once. Throws std::runtime_error when a file is missing or does
+       not match the index, which for an index entry or a label is only found out when its sample is read */
+    class ShardedDataset {
+    private:
+        std::string basePath;
+        MappedFile index;
+        std::vector<MappedFile> shards;
+        const std::uint64_t *entries = nullptr;
+        int sampleCount = 0;
+        int inputSize = 0;
+        int numClasses = 0;
+        double inputScale = 1;
+
+        //Returns the record of a sample, its label followed by its inputs, checking the entry of the index first
+        const std::uint8_t *record(int index) const;
+
+    public:
+        explicit ShardedDataset(const std::string &basePath);
+
+        //Returns the number of samples
+        int size() const;
+
+        int sampleSize() const;
+
+        int classes() const;
+
+        //Returns the factor inputs are multiplied by when a batch is loaded
+        double scale() const;
+
+        int shardCount() const;
+
+        //Returns the raw inputs of a sample, in its mapped shard
+        const std::uint8_t *sample(int index) const;
+
+        int label(int index) const;
+
+        //Converts the samples at the given indices to a batch, reusing the batch's memory when it has the right size
+        void loadBatch(const std::vector<int> &indices, Batch &batch) const;
+    };
+}
+
+#endif //NEURALNETWORK_SHARDEDDATASET_H
@@ -0,0 +1,47 @@
+#ifndef NEURALNETWORK_SHAREDMEMORY_H
+#define NEURALNETWORK_SHAREDMEMORY_H
+
+#include <cstddef>
+#include <string>
+
+namespace neuralNet {
+    /* A named block of memory that processes of the same host map at once: a POSIX shared memory object
+       (shm_open), or a file mapping backed by the paging file on Windows. A new block is filled with zeros. The
+       process that created it removes the name when it goes away, the processes that still map it keep their
+       view. Throws std::runtime_error when anything fails */
+    class SharedMemory {
+    private:
+        void *address = nullptr;
+        std::size_t bytes = 0;
+        std::string name;
+        bool owner = false;
+
+        //The file mapping object on Windows, unused elsewhere
+        void *mapping = nullptr;
+
+        void release();
+
+    public:
+        SharedMemory() = default;
+
+        SharedMemory(const SharedMemory &) = delete;
+        SharedMemory &operator=(const SharedMemory &) = delete;
+
+        SharedMemory(SharedMemory &&other) noexcept;
+        SharedMemory &operator=(SharedMemory &&other) noexcept;
+
+        ~SharedMemory();
+
+        //Creates a block of the given size, replacing one a crashed run may have left under the same name
+        static SharedMemory create(const std::string &name, std::size_t bytes);
+
+        //Maps a block another process created, which must be at least bytes long
+        static SharedMemory open(const std::string &name, std::size_t bytes);
+
+        void *data() const;
+
+        std::size_t size() const;
+    };
+}
+
+#endif //NEURALNETWORK_SHAREDMEMORY_H
@@ -0,0 +1,110 @@
+#ifndef NEURALNETWORK_SHAREDPARAMETERS_H
+#define NEURALNETWORK_SHAREDPARAMETERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "Tensor.h"
+#include "SharedMemory.h"
+
+namespace neuralNet {
+    //Seconds a worker waits for the others, to join or to finish a step, before giving up
+    constexpr int defaultSharedTimeout = 60;
+
+    /* The weights and biases of a network trained by several processes of the same host, in a shared memory
+       segment, with the exact layout of the network's flat parameter buffer (so a checkpoint is a straight copy of
+       the segment). Every worker also has a gradient slot there, which its network back propagates into directly.
+       A step takes no lock: each worker publishes its slot by storing the step number, then adds up every slot over
+       its own range of the parameters (in worker order, so every value gets the same additions whatever the timing)
+       and applies them, and waits until every range is done. The segment is laid out as:
+           header, a cache line per worker for its step, parameters, then a gradient slot per worker */
+    class SharedParameters {
+    private:
+        static constexpr std::uint64_t segmentMagic = 0x4E4E53484152454Dull;
+
+        struct Header {
+            std::uint64_t magic;
+            std::int64_t parameterCount;
+            std::int32_t workerCount;
+
+            //Set once worker 0 wrote the starting parameters
+            std::atomic<std::uint32_t> ready;
+
+            //Ranges applied since the start, workerCount per step
+            std::atomic<std::uint64_t> reducedRanges;
+        };
+
+        //The last step a worker published its gradients for, alone on its cache line so workers do not collide
+        struct alignas(64) SlotState {
+            std::atomic<std::uint64_t> publishedStep;
+        };
+
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free
+                      && std::atomic<std::uint32_t>::is_always_lock_free,
+                      "The atomics of a shared segment must not rely on a lock local to one process");
+
+        SharedMemory memory;
+        int workerIndex = 0;
+        int workers = 1;
+        long count = 0;
+        int timeoutSeconds = defaultSharedTimeout;
+
+        //Set when readCheckpoint filled the parameters, so joining keeps them
+        bool loaded = false;
+
+        //Steps this worker went through
+        std::uint64_t step = 0;
+
+        Header *header = nullptr;
+        SlotState *slotStates = nullptr;
+        double *parameterValues = nullptr;
+        double *gradientSlots = nullptr;
+
+        //Values of a slot, rounded up to a cache line so every slot starts on one
+        long slotSize() const;
+
+        //Returns the size of a segment for the given number of parameters and workers
+        static std::size_t segmentBytes(long parameterCount, int workerCount);
+
+        //Finds the header, slots and buffers in the mapped segment
+        void locate();
+
+        //Spins until the condition holds, throws std::runtime_error when the other workers take too long
+        template<typename Condition>
+        void waitUntil(Condition condition, const char *what) const;
+
+    public:
+        /* Worker 0 creates the segment, the others open it, waiting up to timeoutSeconds for it to appear. All of
+           them must give the same name, worker count and parameter count (NeuralNetwork::parameterBufferSize) */
+        SharedParameters(const std::string &name, int worker, int workerCount, long parameterCount,
+                         int timeoutSeconds = defaultSharedTimeout);
+
+        int worker() const;
+
+        int workerCount() const;
+
+        //The weights and biases in the segment, laid out like the network's buffer
+        TensorView<double> parameters() const;
+
+        //The gradients of this worker, which must be zero outside of a step
+        TensorView<double> gradientSlot() const;
+
+        /* Worker 0 copies the starting parameters into the segment (unless readCheckpoint already filled it),
+           the others wait until it did */
+        void join(TensorView<const double> startingParameters);
+
+        /* Publishes the gradients of this worker for the next step and waits for the others, then applies
+           parameters -= learnRate * (sum of the slots) over this worker's range, clearing the slots there, and
+           returns once every range is done */
+        void reduce(double learnRate);
+
+        //Writes the parameters of the segment to a file, consistent when called between two steps
+        void writeCheckpoint(const std::string &path) const;
+
+        /* Fills the parameters of the segment from a file writeCheckpoint wrote, before worker 0 joins. Throws
+           std::runtime_error when the file is missing or was written for another network */
+        void readCheckpoint(const std::string &path);
+    };
+}
+
+#endif //NEURALNETWORK_SHAREDPARAMETERS_H
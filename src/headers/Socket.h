@@ -0,0 +1,62 @@
+#ifndef NEURALNETWORK_SOCKET_H
+#define NEURALNETWORK_SOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace neuralNet {
+    /* A TCP connection, the same on Windows (winsock) and POSIX systems, which throws std::runtime_error when
+       anything fails. The sockets never block: every wait goes through poll, so a thread can send to one peer while
+       it receives from another without both ends filling their buffers and waiting on each other forever */
+    class Socket {
+    public:
+        //A SOCKET on Windows, a file descriptor elsewhere
+#ifdef _WIN32
+        using Handle = std::uintptr_t;
+#else
+        using Handle = int;
+#endif
+        static constexpr Handle invalidHandle = static_cast<Handle>(-1);
+
+    private:
+        Handle handle = invalidHandle;
+
+        explicit Socket(Handle handle);
+
+    public:
+        Socket() = default;
+
+        Socket(const Socket &) = delete;
+        Socket &operator=(const Socket &) = delete;
+
+        Socket(Socket &&other) noexcept;
+        Socket &operator=(Socket &&other) noexcept;
+
+        ~Socket();
+
+        //Listens for connections on every interface
+        static Socket listen(std::uint16_t port);
+
+        /* Connects to a host, trying again until timeoutSeconds have passed while nothing listens there yet,
+           so the processes of a ring can be started in any order */
+        static Socket connect(const std::string &host, std::uint16_t port, int timeoutSeconds);
+
+        //Waits up to timeoutSeconds for a connection on a listening socket
+        Socket accept(int timeoutSeconds);
+
+        bool isOpen() const;
+
+        void close();
+
+        void sendAll(const void *data, std::size_t bytes);
+
+        void receiveAll(void *data, std::size_t bytes);
+
+        //Sends a buffer through one socket while receiving another from a second one, returns once both are done
+        static void exchange(Socket &sendSocket, const void *sendData, std::size_t sendBytes,
+                             Socket &receiveSocket, void *receiveData, std::size_t receiveBytes);
+    };
+}
+
+#endif //NEURALNETWORK_SOCKET_H
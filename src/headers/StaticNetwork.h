@@ -0,0 +1,282 @@
+#ifndef NEURALNETWORK_STATICNETWORK_H
+#define NEURALNETWORK_STATICNETWORK_H
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "Tensor.h"
+#include "Activation.h"
+#include "Initialization.h"
+#include "Random.h"
+
+namespace neuralNet {
+    namespace detail {
+        template<typename Function, int... Indices>
+        constexpr void staticFor(Function &function, std::integer_sequence<int, Indices...>) {
+            (function(std::integral_constant<int, Indices>()), ...);
+        }
+
+        //Returns the index-th value of the pack
+        template<int... Sizes>
+        constexpr int sizeAt(int index) {
+            constexpr int sizes[] = {Sizes...};
+            return sizes[index];
+        }
+    }
+
+    /* Calls function(std::integral_constant<int, I>()) for I going from 0 to Count - 1. The calls are written out by
+       the compiler, so I is a constant in each of them and can pick template arguments (like which layer to use) */
+    template<int Count, typename Function>
+    constexpr void staticFor(Function &&function) {
+        detail::staticFor(function, std::make_integer_sequence<int, Count>());
+    }
+
+    //A dense sigmoid layer whose size is known at compile time, the weights being indexed as [nodeIn][nodeOut]
+    template<int NodesIn, int NodesOut>
+    struct StaticLayer {
+        std::array<std::array<double, NodesOut>, NodesIn> weights{};
+        std::array<double, NodesOut> biases{};
+
+        //Calculates the activations of the layer, same formula as DenseLayer: b + a1 * w1 + a2 * w2 + ...
+        void computeActivations(const std::array<double, NodesIn> &inputs, std::array<double, NodesOut> &outputs) const {
+            outputs = biases;
+            for (int nodeIn = 0; nodeIn < NodesIn; nodeIn++) {
+                for (int nodeOut = 0; nodeOut < NodesOut; nodeOut++) {
+                    outputs[nodeOut] += inputs[nodeIn] * weights[nodeIn][nodeOut];
+                }
+            }
+            applyActivation(ActivationFunction::Sigmoid, outputs.data(), NodesOut);
+        }
+
+        /* Adds the cost gradients of the weights and biases to gradients, from the derivatives of the cost with
+           respect to the activations. When NeedInputGradients is true, also writes the derivatives with respect to
+           the inputs, in the same pass over the weights */
+        template<bool NeedInputGradients>
+        void backPropagate(const std::array<double, NodesIn> &inputs, const std::array<double, NodesOut> &activations,
+                           const std::array<double, NodesOut> &outputGradients, StaticLayer &gradients,
+                           std::array<double, NodesIn> &inputGradients) const {
+            std::array<double, NodesOut> gradientProducts;
+            multiplyActivationDerivative(ActivationFunction::Sigmoid, activations.data(), outputGradients.data(),
+                                         gradientProducts.data(), NodesOut);
+
+            for (int nodeOut = 0; nodeOut < NodesOut; nodeOut++) {
+                gradients.biases[nodeOut] += gradientProducts[nodeOut];
+            }
+            for (int nodeIn = 0; nodeIn < NodesIn; nodeIn++) {
+                double weightedGradient = 0;
+                for (int nodeOut = 0; nodeOut < NodesOut; nodeOut++) {
+                    weightedGradient += weights[nodeIn][nodeOut] * gradientProducts[nodeOut];
+                    gradients.weights[nodeIn][nodeOut] += inputs[nodeIn] * gradientProducts[nodeOut];
+                }
+                if constexpr (NeedInputGradients) {
+                    inputGradients[nodeIn] = weightedGradient;
+                }
+            }
+        }
+    };
+
+    /* A network of dense sigmoid layers whose sizes are template arguments, StaticNetwork<784, 100, 10> being the
+       same network as NeuralNetwork({784, 100, 10}). Every weight, activation and gradient lives in a std::array
+       (in the object or on the stack), so nothing is ever allocated, and every loop has a bound the compiler knows,
+       so it can unroll and vectorize them completely. The layers themselves are visited with staticFor, which
+       writes out a call per layer. Meant for tiny models called millions of times, where the bookkeeping of the
+       batched network costs more than the math. Uses the same activation and cost functions as NeuralNetwork */
+    template<int... Sizes>
+    class StaticNetwork {
+    public:
+        static_assert(sizeof...(Sizes) >= 2, "A network needs an input and at least one layer");
+
+        static constexpr int layerCount = static_cast<int>(sizeof...(Sizes)) - 1;
+        static constexpr int inputSize = detail::sizeAt<Sizes...>(0);
+        static constexpr int outputSize = detail::sizeAt<Sizes...>(layerCount);
+
+        using Inputs = std::array<double, inputSize>;
+        using Outputs = std::array<double, outputSize>;
+
+    private:
+        template<int... Layers>
+        static auto layersOf(std::integer_sequence<int, Layers...>)
+        -> std::tuple<StaticLayer<detail::sizeAt<Sizes...>(Layers), detail::sizeAt<Sizes...>(Layers + 1)>...>;
+
+        template<int... Layers>
+        static auto activationsOf(std::integer_sequence<int, Layers...>)
+        -> std::tuple<std::array<double, detail::sizeAt<Sizes...>(Layers + 1)>...>;
+
+        //One StaticLayer per layer, and one array of values per layer output
+        using LayerTuple = decltype(layersOf(std::make_integer_sequence<int, layerCount>()));
+        using ActivationTuple = decltype(activationsOf(std::make_integer_sequence<int, layerCount>()));
+
+        LayerTuple layers;
+
+        //Cost gradients of every weight and bias, with the same layout as the layers
+        LayerTuple gradients;
+
+        //Returns what the layer gets as inputs: the network inputs, or the activations of the layer before it
+        template<int Layer>
+        static const auto &layerInputs(const Inputs &inputs, const ActivationTuple &activations) {
+            if constexpr (Layer == 0) {
+                return inputs;
+            } else {
+                return std::get<Layer - 1>(activations);
+            }
+        }
+
+        //Runs the inputs through every layer, keeping the activations of each one
+        void calculateOutputs(const Inputs &inputs, ActivationTuple &activations) const {
+            staticFor<layerCount>([&](auto index) {
+                constexpr int layer = decltype(index)::value;
+                std::get<layer>(layers).computeActivations(layerInputs<layer>(inputs, activations),
+                                                           std::get<layer>(activations));
+            });
+        }
+
+    public:
+        //Initializes the weights and biases with the Gaussian distribution, from a random seed
+        StaticNetwork() : StaticNetwork(randomSeed()) {}
+
+        /* Initializes the weights and biases the way NeuralNetwork does, layer i from mixSeed(seed, i), so
+           StaticNetwork<784, 100, 10>(seed) starts out with the weights of NeuralNetwork({784, 100, 10}, n, seed).
+           The values are drawn on the calling thread, so building a network starts no thread pool */
+        explicit StaticNetwork(std::uint64_t seed) {
+            staticFor<layerCount>([&](auto index) {
+                constexpr int layer = decltype(index)::value;
+                auto &values = std::get<layer>(layers);
+                constexpr long weightCount = static_cast<long>(detail::sizeAt<Sizes...>(layer))
+                                             * detail::sizeAt<Sizes...>(layer + 1);
+                Philox::Key key = Philox::key(mixSeed(seed, layer));
+                fillNormal(values.weights[0].data(), 0, weightCount, 1.0, key, weightInitStream);
+                fillNormal(values.biases.data(), 0, static_cast<long>(values.biases.size()), 1.0, key, biasInitStream);
+            });
+        }
+
+        //Returns the activations of the output layer for the inputs
+        Outputs predict(const Inputs &inputs) const {
+            ActivationTuple activations;
+            calculateOutputs(inputs, activations);
+            return std::get<layerCount - 1>(activations);
+        }
+
+        //Gets the output node with the highest activation value
+        int classify(const Inputs &inputs) const {
+            Outputs outputs = predict(inputs);
+            int maxNode = 0;
+            for (int node = 1; node < outputSize; node++) {
+                if (outputs[node] > outputs[maxNode]) {
+                    maxNode = node;
+                }
+            }
+            return maxNode;
+        }
+
+        //Calculates the cost of a single sample
+        double cost(const Inputs &inputs, const Outputs &expectedOutputs) const {
+            Outputs outputs = predict(inputs);
+            double cost = 0;
+            for (int node = 0; node < outputSize; node++) {
+                cost += squaredError(outputs[node], expectedOutputs[node]);
+            }
+            return cost;
+        }
+
+        //Back propagates a single sample, adding its part of the cost gradient of every weight and bias
+        void backPropagation(const Inputs &inputs, const Outputs &expectedOutputs) {
+            ActivationTuple activations;
+            calculateOutputs(inputs, activations);
+
+            //Derivatives of the cost with respect to the outputs of each layer, starting from the output layer
+            ActivationTuple outputGradients;
+            for (int node = 0; node < outputSize; node++) {
+                std::get<layerCount - 1>(outputGradients)[node] =
+                        squaredErrorDerivative(std::get<layerCount - 1>(activations)[node], expectedOutputs[node]);
+            }
+
+            //Each layer hands the derivatives with respect to its inputs over to the layer before it
+            staticFor<layerCount>([&](auto step) {
+                constexpr int layer = layerCount - 1 - decltype(step)::value;
+                if constexpr (layer > 0) {
+                    std::get<layer>(layers).template backPropagate<true>(
+                            layerInputs<layer>(inputs, activations), std::get<layer>(activations),
+                            std::get<layer>(outputGradients), std::get<layer>(gradients),
+                            std::get<layer - 1>(outputGradients));
+                } else {
+                    //The first layer has no layer before it, so it only needs its own gradients
+                    Inputs unused;
+                    std::get<0>(layers).template backPropagate<false>(
+                            inputs, std::get<0>(activations), std::get<0>(outputGradients), std::get<0>(gradients),
+                            unused);
+                }
+            });
+        }
+
+        //Applies the accumulated cost gradients and clears them
+        void applyGradients(double learnRate) {
+            staticFor<layerCount>([&](auto index) {
+                constexpr int layer = decltype(index)::value;
+                auto &layerParameters = std::get<layer>(layers);
+                auto &layerGradients = std::get<layer>(gradients);
+                for (int nodeIn = 0; nodeIn < layerParameters.weights.size(); nodeIn++) {
+                    for (int nodeOut = 0; nodeOut < layerParameters.biases.size(); nodeOut++) {
+                        layerParameters.weights[nodeIn][nodeOut] -= layerGradients.weights[nodeIn][nodeOut] * learnRate;
+                    }
+                }
+                for (int nodeOut = 0; nodeOut < layerParameters.biases.size(); nodeOut++) {
+                    layerParameters.biases[nodeOut] -= layerGradients.biases[nodeOut] * learnRate;
+                }
+                layerGradients = {};
+            });
+        }
+
+        //Does a step of gradient descent over count samples, averaging their gradients
+        void gradientDescent(const Inputs *inputs, const Outputs *expectedOutputs, int count, double learnRate = 1) {
+            for (int sample = 0; sample < count; sample++) {
+                backPropagation(inputs[sample], expectedOutputs[sample]);
+            }
+            applyGradients(learnRate / count);
+        }
+
+        /* Replaces the weights and biases of a layer, the weights being shaped [nodeIn, nodeOut] like the ones
+           NeuralNetwork::copyLayerParameters gives, so a model trained by NeuralNetwork can be deployed here.
+           Throws std::invalid_argument when the shapes do not match */
+        void setLayerParameters(int index, TensorView<const double> weights, TensorView<const double> biases) {
+            bool found = false;
+            staticFor<layerCount>([&](auto layerIndex) {
+                constexpr int layer = decltype(layerIndex)::value;
+                auto &layerParameters = std::get<layer>(layers);
+                long nodesIn = static_cast<long>(layerParameters.weights.size());
+                long nodesOut = static_cast<long>(layerParameters.biases.size());
+                if (layer != index) {
+                    return;
+                }
+                if (weights.rank() != 2 || weights.dim(0) != nodesIn || weights.dim(1) != nodesOut
+                    || biases.size() != nodesOut) {
+                    throw std::invalid_argument("Parameters do not match the shape of layer " + std::to_string(index));
+                }
+
+                found = true;
+                for (long nodeIn = 0; nodeIn < nodesIn; nodeIn++) {
+                    for (long nodeOut = 0; nodeOut < nodesOut; nodeOut++) {
+                        layerParameters.weights[nodeIn][nodeOut] = weights(nodeIn, nodeOut);
+                    }
+                }
+                for (long nodeOut = 0; nodeOut < nodesOut; nodeOut++) {
+                    layerParameters.biases[nodeOut] = biases[nodeOut];
+                }
+            });
+            if (!found) {
+                throw std::invalid_argument("The network has no layer " + std::to_string(index));
+            }
+        }
+
+        //Returns the layer at the given index, the first layer after the input being at index 0
+        template<int Layer>
+        const auto &layer() const {
+            return std::get<Layer>(layers);
+        }
+    };
+}
+
+#endif //NEURALNETWORK_STATICNETWORK_H
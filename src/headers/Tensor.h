@@ -0,0 +1,371 @@
+#ifndef NEURALNETWORK_TENSOR_H
+#define NEURALNETWORK_TENSOR_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace neuralNet {
+    //Every tensor allocation starts on a cache line, so rows can be loaded with aligned vector instructions
+    constexpr std::size_t tensorAlignment = 64;
+
+    //Tensors have at most 4 dimensions, enough for a batch of multi channel images
+    constexpr int maxTensorRank = 4;
+
+    /* Non-owning view over a block of values, with a shape and the strides (in elements) of each dimension.
+       Views are cheap to copy and never allocate, slicing and reshaping them just creates another view.
+       Constness is shallow, like a pointer: a const view still allows writing the values it points to,
+       use TensorView<const T> for read only access */
+    template<typename T>
+    class TensorView {
+    private:
+        T *values = nullptr;
+        int tensorRank = 0;
+        std::array<long, maxTensorRank> tensorShape{};
+        std::array<long, maxTensorRank> tensorStrides{};
+
+        template<typename>
+        friend class TensorView;
+
+    public:
+        TensorView() = default;
+
+        //Creates a contiguous, row major view with the given shape
+        TensorView(T *values, std::initializer_list<long> shape) : values(values) {
+            assert(shape.size() <= maxTensorRank);
+            tensorRank = static_cast<int>(shape.size());
+            std::copy(shape.begin(), shape.end(), tensorShape.begin());
+
+            long stride = 1;
+            for (int dimension = tensorRank - 1; dimension >= 0; dimension--) {
+                tensorStrides[dimension] = stride;
+                stride *= tensorShape[dimension];
+            }
+        }
+
+        //Creates a contiguous vector view
+        TensorView(T *values, long size) : TensorView(values, {size}) {}
+
+        //A view of non-const values can always be used as a view of const values
+        template<typename U, typename = std::enable_if_t<std::is_same_v<const U, T> && !std::is_same_v<U, T>>>
+        TensorView(const TensorView<U> &other) : values(other.values), tensorRank(other.tensorRank),
+                                                 tensorShape(other.tensorShape), tensorStrides(other.tensorStrides) {}
+
+        T *data() const {
+            return values;
+        }
+
+        int rank() const {
+            return tensorRank;
+        }
+
+        long dim(int dimension) const {
+            return tensorShape[dimension];
+        }
+
+        long stride(int dimension) const {
+            return tensorStrides[dimension];
+        }
+
+        //Returns the number of values in the view
+        long size() const {
+            long size = tensorRank > 0 ? 1 : 0;
+            for (int dimension = 0; dimension < tensorRank; dimension++) {
+                size *= tensorShape[dimension];
+            }
+            return size;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        //Returns true if the values are laid out one after the other, in row major order
+        bool contiguous() const {
+            long stride = 1;
+            for (int dimension = tensorRank - 1; dimension >= 0; dimension--) {
+                if (tensorShape[dimension] != 1 && tensorStrides[dimension] != stride) {
+                    return false;
+                }
+                stride *= tensorShape[dimension];
+            }
+            return true;
+        }
+
+        //Flat access, only valid on contiguous views
+        T &operator[](long index) const {
+            return values[index];
+        }
+
+        T &operator()(long i) const {
+            return values[i * tensorStrides[0]];
+        }
+
+        T &operator()(long i, long j) const {
+            return values[i * tensorStrides[0] + j * tensorStrides[1]];
+        }
+
+        T &operator()(long i, long j, long k) const {
+            return values[i * tensorStrides[0] + j * tensorStrides[1] + k * tensorStrides[2]];
+        }
+
+        T &operator()(long i, long j, long k, long l) const {
+            return values[i * tensorStrides[0] + j * tensorStrides[1] + k * tensorStrides[2] + l * tensorStrides[3]];
+        }
+
+        //Iterators over the values, only valid on contiguous views
+        T *begin() const {
+            return values;
+        }
+
+        T *end() const {
+            return values + size();
+        }
+
+        //Returns the index-th entry along the first dimension, with one dimension less
+        TensorView row(long index) const {
+            TensorView row;
+            row.values = values + index * tensorStrides[0];
+            row.tensorRank = tensorRank - 1;
+            std::copy(tensorShape.begin() + 1, tensorShape.end(), row.tensorShape.begin());
+            std::copy(tensorStrides.begin() + 1, tensorStrides.end(), row.tensorStrides.begin());
+            return row;
+        }
+
+        //Returns the entries [begin, end) along the first dimension
+        TensorView slice(long begin, long end) const {
+            TensorView slice = *this;
+            slice.values = values + begin * tensorStrides[0];
+            slice.tensorShape[0] = end - begin;
+            return slice;
+        }
+
+        //Returns the same values seen with another shape, only valid on contiguous views
+        TensorView reshape(std::initializer_list<long> shape) const {
+            assert(contiguous());
+            TensorView reshaped(values, shape);
+            assert(reshaped.size() == size());
+            return reshaped;
+        }
+
+        //Returns a view where the first two dimensions are swapped, without moving any value
+        TensorView transpose() const {
+            TensorView transposed = *this;
+            std::swap(transposed.tensorShape[0], transposed.tensorShape[1]);
+            std::swap(transposed.tensorStrides[0], transposed.tensorStrides[1]);
+            return transposed;
+        }
+
+        //Sets every value of the view
+        void fill(T value) const {
+            if (contiguous()) {
+                std::fill(values, values + size(), value);
+                return;
+            }
+            for (long i = 0; i < tensorShape[0]; i++) {
+                row(i).fill(value);
+            }
+        }
+
+        //Copies the values of another view with the same shape into this one
+        void copyFrom(const TensorView<const std::remove_const_t<T>> &other) const {
+            assert(other.size() == size());
+            if (contiguous() && other.contiguous()) {
+                std::copy(other.data(), other.data() + other.size(), values);
+                return;
+            }
+            if (tensorRank == 1) {
+                for (long i = 0; i < tensorShape[0]; i++) {
+                    (*this)(i) = other(i);
+                }
+                return;
+            }
+            for (long i = 0; i < tensorShape[0]; i++) {
+                row(i).copyFrom(other.row(i));
+            }
+        }
+    };
+
+    /* Owning tensor, storing its values in a single 64 byte aligned allocation.
+       It can be used anywhere a view is expected, copying it copies the values */
+    template<typename T>
+    class Tensor {
+    private:
+        struct AlignedDeleter {
+            void operator()(T *values) const {
+                ::operator delete(values, std::align_val_t(tensorAlignment));
+            }
+        };
+
+        std::unique_ptr<T, AlignedDeleter> storage;
+        TensorView<T> tensorView;
+
+        static T *allocate(long size) {
+            if (size == 0) {
+                return nullptr;
+            }
+            return static_cast<T *>(::operator new(size * sizeof(T), std::align_val_t(tensorAlignment)));
+        }
+
+    public:
+        static_assert(std::is_trivially_copyable_v<T>, "Tensors only store plain values");
+
+        Tensor() = default;
+
+        //Creates a tensor with the given shape, with every value set to 0
+        explicit Tensor(std::initializer_list<long> shape) {
+            TensorView<T> shaped(nullptr, shape);
+            storage.reset(allocate(shaped.size()));
+            tensorView = TensorView<T>(storage.get(), shape);
+            tensorView.fill(T());
+        }
+
+        //Creates a vector with a copy of the values
+        template<typename Container, typename = typename Container::value_type>
+        explicit Tensor(const Container &container) : Tensor({static_cast<long>(container.size())}) {
+            std::copy(container.data(), container.data() + container.size(), storage.get());
+        }
+
+        //Creates a tensor with a copy of the values in the view
+        explicit Tensor(const TensorView<const T> &other) {
+            copyShapeOf(other);
+            tensorView.copyFrom(other);
+        }
+
+        Tensor(const Tensor &other) : Tensor(other.view()) {}
+
+        //A moved from tensor is empty, its view would otherwise still point into the values it gave away
+        Tensor(Tensor &&other) noexcept : storage(std::move(other.storage)), tensorView(other.tensorView) {
+            other.tensorView = TensorView<T>();
+        }
+
+        Tensor &operator=(const Tensor &other) {
+            if (this != &other) {
+                copyShapeOf(other.view());
+                tensorView.copyFrom(other.view());
+            }
+            return *this;
+        }
+
+        Tensor &operator=(Tensor &&other) noexcept {
+            if (this != &other) {
+                storage = std::move(other.storage);
+                tensorView = other.tensorView;
+                other.tensorView = TensorView<T>();
+            }
+            return *this;
+        }
+
+        /* Gives the tensor the same shape as the view, reusing the allocation when the size did not change.
+           The values are left as they were, they are not copied from the view */
+        void copyShapeOf(const TensorView<const T> &other) {
+            if (other.size() != size()) {
+                storage.reset(allocate(other.size()));
+            }
+            long shape[maxTensorRank];
+            for (int dimension = 0; dimension < other.rank(); dimension++) {
+                shape[dimension] = other.dim(dimension);
+            }
+            switch (other.rank()) {
+                case 0: tensorView = TensorView<T>(); break;
+                case 1: tensorView = TensorView<T>(storage.get(), {shape[0]}); break;
+                case 2: tensorView = TensorView<T>(storage.get(), {shape[0], shape[1]}); break;
+                case 3: tensorView = TensorView<T>(storage.get(), {shape[0], shape[1], shape[2]}); break;
+                default: tensorView = TensorView<T>(storage.get(), {shape[0], shape[1], shape[2], shape[3]});
+            }
+        }
+
+        TensorView<T> view() {
+            return tensorView;
+        }
+
+        TensorView<const T> view() const {
+            return tensorView;
+        }
+
+        operator TensorView<T>() {
+            return tensorView;
+        }
+
+        operator TensorView<const T>() const {
+            return tensorView;
+        }
+
+        T *data() {
+            return tensorView.data();
+        }
+
+        const T *data() const {
+            return tensorView.data();
+        }
+
+        int rank() const {
+            return tensorView.rank();
+        }
+
+        long dim(int dimension) const {
+            return tensorView.dim(dimension);
+        }
+
+        long size() const {
+            return tensorView.size();
+        }
+
+        bool empty() const {
+            return tensorView.empty();
+        }
+
+        T &operator[](long index) {
+            return tensorView[index];
+        }
+
+        const T &operator[](long index) const {
+            return tensorView[index];
+        }
+
+        template<typename... Indices>
+        T &operator()(Indices... indices) {
+            return tensorView(indices...);
+        }
+
+        template<typename... Indices>
+        const T &operator()(Indices... indices) const {
+            return tensorView(indices...);
+        }
+
+        T *begin() {
+            return tensorView.begin();
+        }
+
+        T *end() {
+            return tensorView.end();
+        }
+
+        const T *begin() const {
+            return tensorView.begin();
+        }
+
+        const T *end() const {
+            return tensorView.end();
+        }
+
+        TensorView<T> row(long index) {
+            return tensorView.row(index);
+        }
+
+        TensorView<const T> row(long index) const {
+            return view().row(index);
+        }
+
+        void fill(T value) {
+            tensorView.fill(value);
+        }
+    };
+}
+
+#endif //NEURALNETWORK_TENSOR_H
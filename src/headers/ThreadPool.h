@@ -0,0 +1,83 @@
+#ifndef NEURALNETWORK_THREADPOOL_H
+#define NEURALNETWORK_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace neuralNet {
+    /* A fixed set of worker threads that run the tasks of one job at a time. The thread that starts a job works on
+       it too, and waits until every task is done, so a job behaves like a plain (blocking) loop. Tasks are handed
+       out by index, which thread runs which task is not fixed, so anything that must not depend on the number of
+       threads (like random numbers or sums) has to be tied to the task index rather than to the thread */
+    class ThreadPool {
+    private:
+        std::vector<std::thread> workers;
+
+        //Only one job runs at a time, other callers wait for their turn
+        std::mutex jobMutex;
+
+        std::mutex stateMutex;
+        std::condition_variable jobStarted;
+        std::condition_variable jobFinished;
+
+        //The job being run: its tasks, the next task to hand out, and how many are done
+        const std::function<void(long)> *task = nullptr;
+        long taskCount = 0;
+        std::atomic<long> nextTask{0};
+        long finishedTasks = 0;
+
+        //Workers inside runTasks, a job only ends once they all left so none of them can see the next one half set up
+        int activeWorkers = 0;
+
+        //Incremented for every job, so the workers can tell a new job from the one they just finished
+        unsigned long jobNumber = 0;
+        bool stopping = false;
+
+        //First exception thrown by a task of the current job, rethrown by run
+        std::exception_ptr error;
+
+        //Runs tasks of the current job until there are none left, returns how many it ran
+        long runTasks();
+
+        //Hands the tasks out to the workers and the caller, and waits until all of them are done
+        void runJob(long count, const std::function<void(long)> &task);
+
+        void workerLoop();
+
+    public:
+        //Starts threadCount - 1 workers, the caller of run being the last thread
+        explicit ThreadPool(int threadCount = static_cast<int>(std::thread::hardware_concurrency()));
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        ~ThreadPool();
+
+        //Returns the number of threads working on a job, the caller included
+        int threadCount() const;
+
+        /* Calls task(index) for every index in [0, count) and returns once all of them are done, rethrowing the
+           first exception a task threw. Called from inside a task, it runs the whole job on the calling thread */
+        void run(long count, const std::function<void(long)> &task);
+
+        /* Cuts [begin, end) into chunks of chunkSize (the last one can be shorter) and calls body(chunkBegin, chunkEnd)
+           for each of them. The chunks only depend on the arguments, never on the number of threads */
+        void parallelFor(long begin, long end, long chunkSize, const std::function<void(long, long)> &body);
+
+        /* Calls task(index) for every index in [0, count) at the same time, each on a thread of the pool, for tasks
+           that wait on each other and so would hang sharing a thread. Unlike run, it never falls back to a loop, even
+           from inside a task of another pool, which is why it must not be called from a task of this one. Throws
+           std::logic_error when the pool has fewer threads than tasks, and rethrows the first exception a task threw */
+        void runConcurrently(long count, const std::function<void(long)> &task);
+
+        //Returns the pool shared by the whole program, with a thread per core
+        static ThreadPool &global();
+    };
+}
+
+#endif //NEURALNETWORK_THREADPOOL_H
@@ -0,0 +1,79 @@
+#ifndef NEURALNETWORK_VISUALIZER_H
+#define NEURALNETWORK_VISUALIZER_H
+
+#include <GLFW/glfw3.h>
+#include <vector>
+#include "NeuralNetwork.h"
+#include "../../libs/imgui/imgui.h"
+
+//Creates an RGBA texture with nearest filtering, so single pixels stay sharp when scaled up
+GLuint createImageTexture(int width, int height);
+
+//Replaces the whole content of a texture created with createImageTexture
+void uploadImageTexture(GLuint texture, int width, int height, const unsigned char *pixels);
+
+//Converts an OpenGL texture to the id ImGui::Image expects
+ImTextureID toImTexture(GLuint texture);
+
+/* Draws the weights of the first layer and the activations of every layer for a chosen sample.
+   Everything is uploaded to OpenGL textures and drawn with a single ImGui::Image per texture, so big
+   layers cost the same to draw as small ones. Textures are only updated when the weights changed,
+   and at most once every uploadInterval seconds, so the training thread is barely ever locked */
+class NetworkVisualizer {
+private:
+    neuralNet::NeuralNetwork *network = nullptr;
+    const neuralNet::Dataset *dataset = nullptr;
+    neuralNet::Batch sampleBatch;
+
+    //Seconds between two texture updates
+    float uploadInterval = 0.25f;
+    double lastUploadTime = -1;
+
+    //Version of the network parameters and sample currently shown by the textures
+    unsigned long uploadedVersion = 0;
+    int uploadedSample = -1;
+    int selectedSample = 0;
+
+    /* Every node (or channel) of the first layer with weights gets a tile, showing the weight of each of its inputs.
+       weightsLayer is its index, or the number of layers when no layer has weights */
+    int weightsLayer = 0;
+    GLuint weightsTexture = 0;
+    int tileWidth = 0;
+    int tileHeight = 0;
+    int tilesPerRow = 0;
+    int atlasWidth = 0;
+    int atlasHeight = 0;
+
+    //One texture per layer (input layer included), with a pixel per node
+    std::vector<GLuint> activationTextures;
+    std::vector<int> activationWidths;
+    std::vector<int> activationHeights;
+
+    //Reused between uploads, so updating the textures does not allocate
+    neuralNet::Tensor<double> weights;
+    neuralNet::Tensor<double> biases;
+    std::vector<unsigned char> pixels;
+
+    //Creates the textures the first time the network is drawn
+    void createTextures();
+
+    //Copies the weights of the shown layer into the atlas texture
+    void uploadWeights();
+
+    //Runs the selected sample through the network and uploads the activations of each layer
+    void uploadActivations();
+
+public:
+    NetworkVisualizer() = default;
+
+    //Sets the network and the dataset to visualize, neither is owned by the visualizer
+    void attach(neuralNet::NeuralNetwork *network, const neuralNet::Dataset *dataset);
+
+    //Draws the visualizer window, must be called between ImGui::NewFrame() and ImGui::Render()
+    void draw();
+
+    //Deletes the textures, must be called while the OpenGL context is still alive
+    void release();
+};
+
+#endif //NEURALNETWORK_VISUALIZER_H
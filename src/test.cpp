@@ -1,73 +0,0 @@
-#include <GLFW/glfw3.h>
-#include "../libs/imgui/imgui.h"
-#include "../libs/imgui/imgui_impl_opengl3.h"
-#include "../libs/imgui/imgui_impl_glfw.h"
-#include "headers/GUI.h"
-#include <iostream>
-
-void functionThatWorks() {
-    // Initialize GLFW
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // Create a GLFW window
-    GLFWwindow* window = glfwCreateWindow(800, 600, "ImGui GLFW Example", nullptr, nullptr);
-    if (window == nullptr)
-    {
-        glfwTerminate();
-        return;
-    }
-
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);
-
-    // Initialize ImGui
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO();
-    (void)io;
-
-    // Setup ImGui bindings for GLFW
-    ImGui_ImplGlfw_InitForOpenGL(window, true);
-    ImGui_ImplOpenGL3_Init("#version 330 core");
-
-    // Main loop
-    while (!glfwWindowShouldClose(window))
-    {
-        glfwPollEvents();
-
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-
-        // ImGui rendering
-        ImGui::Begin("Hello, ImGui!");
-        ImGui::Text("Welcome to ImGui!");
-        ImGui::End();
-
-        // Render
-        glClearColor(0.45f, 0.55f, 0.60f, 1.00f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-        glfwSwapBuffers(window);
-    }
-
-    // Cleanup
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
-
-    glfwDestroyWindow(window);
-    glfwTerminate();
-}
-
-//int main()
-//{
-//    GUIWindow window(500, 500, "fds");
-//    window.run();
-//    return 0;
-//}